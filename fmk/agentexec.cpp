@@ -0,0 +1,182 @@
+/******************************************************************************
+ * File:    agentexec.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.AgentExecutor
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement AgentExecutor class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#include "agentexec.h"
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+AgentExecutor::AgentExecutor(int _numOfWorkers)
+    : numOfWorkers(_numOfWorkers < 1 ? 1 : _numOfWorkers), quit(false)
+{
+}
+
+//----------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------
+AgentExecutor::~AgentExecutor()
+{
+    stop();
+}
+
+//----------------------------------------------------------------------
+// Method: add
+// Registers a new machine, and returns its handle
+//----------------------------------------------------------------------
+int AgentExecutor::add(StepFn fn)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    int h = (int)(entries.size());
+    entries.push_back(Entry {fn, Idle, false, Clock::time_point()});
+    enqueue(h);
+    return h;
+}
+
+//----------------------------------------------------------------------
+// Method: notify
+// Runs the next step of the machine as soon as possible
+//----------------------------------------------------------------------
+void AgentExecutor::notify(int h)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    enqueue(h);
+}
+
+//----------------------------------------------------------------------
+// Method: start
+// Launches the worker threads
+//----------------------------------------------------------------------
+void AgentExecutor::start()
+{
+    if (! workers.empty()) { return; }
+    quit = false;
+    for (int i = 0; i < numOfWorkers; ++i) {
+        workers.push_back(std::thread(&AgentExecutor::work, this));
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: stop
+// Stops the worker threads, once their current steps are done
+//----------------------------------------------------------------------
+void AgentExecutor::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        quit = true;
+    }
+    cv.notify_all();
+    for (auto & thr: workers) { thr.join(); }
+    workers.clear();
+}
+
+//----------------------------------------------------------------------
+// Method: enqueue
+// Marks the machine as ready to run (lock must be held)
+//----------------------------------------------------------------------
+void AgentExecutor::enqueue(int h)
+{
+    Entry & e = entries.at(h);
+    switch (e.state) {
+    case Idle:
+        e.state = Queued;
+        e.timed = false;
+        ready.push_back(h);
+        cv.notify_one();
+        break;
+    case Running:
+        e.state = RunningNotified;
+        break;
+    default:
+        break;
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: work
+// Worker thread loop: runs the ready machines, and moves to the ready
+// queue those whose timer expired
+//----------------------------------------------------------------------
+void AgentExecutor::work()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (! quit) {
+        Clock::time_point now = Clock::now();
+        while ((! timers.empty()) && (timers.top().first <= now)) {
+            Timer t = timers.top();
+            timers.pop();
+            Entry & e = entries.at(t.second);
+            // Timers superseded by a later step are ignored
+            if (e.timed && (e.due == t.first)) { enqueue(t.second); }
+        }
+
+        if (ready.empty()) {
+            if (timers.empty()) {
+                cv.wait(lock);
+            } else {
+                cv.wait_until(lock, timers.top().first);
+            }
+            continue;
+        }
+
+        int h = ready.front();
+        ready.pop_front();
+        Entry & e = entries.at(h);
+        e.state = Running;
+
+        lock.unlock();
+        int ms = e.fn();
+        lock.lock();
+
+        if (e.state == RunningNotified) {
+            e.state = Idle;
+            enqueue(h);
+        } else {
+            e.state = Idle;
+            if (ms >= 0) {
+                e.timed = true;
+                e.due = Clock::now() + std::chrono::milliseconds(ms);
+                timers.push(Timer(e.due, h));
+                // Other workers may be waiting for a later timer
+                cv.notify_one();
+            }
+        }
+    }
+}
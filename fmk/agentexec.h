@@ -0,0 +1,157 @@
+/******************************************************************************
+ * File:    agentexec.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.AgentExecutor
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare AgentExecutor class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#ifndef AGENTEXECUTOR_H
+#define AGENTEXECUTOR_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - functional
+//   - vector
+//   - deque
+//   - queue
+//   - thread
+//------------------------------------------------------------
+#include <functional>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+
+//==========================================================================
+// Class: AgentExecutor
+// Runs the steps of a (potentially large) number of state machines on a
+// small pool of worker threads.  A step is run when the machine is
+// notified of a new event, or when the timer requested by its previous
+// step expires.  Each step returns the number of milliseconds until it
+// must be run again, or a negative value to wait for a notification.
+// The steps of a given machine are never run concurrently.
+//==========================================================================
+class AgentExecutor {
+
+public:
+    typedef std::function<int()> StepFn;
+
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    AgentExecutor(int _numOfWorkers = 4);
+
+    //----------------------------------------------------------------------
+    // Destructor
+    //----------------------------------------------------------------------
+    virtual ~AgentExecutor();
+
+    //----------------------------------------------------------------------
+    // Method: add
+    // Registers a new machine, and returns its handle.  Its first step
+    // will be run as soon as the executor is started
+    //----------------------------------------------------------------------
+    int add(StepFn fn);
+
+    //----------------------------------------------------------------------
+    // Method: notify
+    // Runs the next step of the machine as soon as possible
+    //----------------------------------------------------------------------
+    void notify(int h);
+
+    //----------------------------------------------------------------------
+    // Method: start
+    //----------------------------------------------------------------------
+    void start();
+
+    //----------------------------------------------------------------------
+    // Method: stop
+    //----------------------------------------------------------------------
+    void stop();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::pair<Clock::time_point, int> Timer;
+
+    enum EntryState { Idle, Queued, Running, RunningNotified };
+
+    struct Entry {
+        StepFn            fn;
+        EntryState        state;
+        bool              timed;
+        Clock::time_point due;
+    };
+
+    //----------------------------------------------------------------------
+    // Method: work
+    // Worker thread loop
+    //----------------------------------------------------------------------
+    void work();
+
+    //----------------------------------------------------------------------
+    // Method: enqueue
+    //----------------------------------------------------------------------
+    void enqueue(int h);
+
+private:
+    int numOfWorkers;
+    bool quit;
+
+    std::deque<Entry> entries;
+    std::deque<int> ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<std::thread> workers;
+};
+
+#endif // AGENTEXECUTOR_H
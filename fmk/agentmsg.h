@@ -0,0 +1,130 @@
+/******************************************************************************
+ * File:    agentmsg.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.AgentMsg
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare messages exchanged between TaskManager and TaskAgents
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#ifndef AGENTMSG_H
+#define AGENTMSG_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//------------------------------------------------------------
+#include <string>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+#include "types.h"
+#include "spscring.h"
+
+//==========================================================================
+// Struct: TaskAssignment
+// New task sent by the manager to an agent.  The group is the id of the
+// original task for speculative copies of it; a cancellation withdraws
+// a task already sent
+//==========================================================================
+struct TaskAssignment {
+    std::string taskId;
+    std::string taskFolder;
+    std::string processor;
+    std::string group;
+    bool        cancel;
+};
+
+//==========================================================================
+// Struct: SpectrumUpdate
+// Number of containers of an agent in each of the task states.  Counts
+// are indexed by status value, starting at TASK_SCHEDULED
+//==========================================================================
+struct SpectrumUpdate {
+    static const int NumOfStates = TASK_UNKNOWN_STATE - TASK_SCHEDULED + 1;
+
+    int counts[NumOfStates];
+
+    static int index(int statusVal) { return statusVal - TASK_SCHEDULED; }
+};
+
+//==========================================================================
+// Struct: TaskStatusUpdate
+// Status of a task (and its container) reported by an agent.  Tasks
+// killed by the agent watchdog are flagged as hung
+//==========================================================================
+struct TaskStatusUpdate {
+    bool           justCreated;
+    std::string    taskId;
+    std::string    contId;
+    std::string    inspect;
+    int            percent;
+    TaskStatusEnum status;
+    bool           hung;
+};
+
+//==========================================================================
+// Struct: ContainerEvent
+// Container life-cycle event (start, die, oom) sent to the owning agent,
+// or a change in the connection to the events source (connected,
+// disconnected) sent to all of them
+//==========================================================================
+struct ContainerEvent {
+    std::string contId;
+    std::string action;
+    std::string owner;
+    int         exitCode;
+};
+
+//==========================================================================
+// Channels between TaskManager and each TaskAgent.  Each of them has
+// only one producer (the manager for the assignments, the events
+// monitor for the container events, the agent for the others) and one
+// consumer
+//==========================================================================
+typedef SpscRing<TaskAssignment, 256>   TaskAssignmentRing;
+typedef SpscRing<SpectrumUpdate, 64>    SpectrumUpdateRing;
+typedef SpscRing<TaskStatusUpdate, 256> TaskStatusUpdateRing;
+typedef SpscRing<ContainerEvent, 256>   ContainerEventRing;
+
+#endif // AGENTMSG_H
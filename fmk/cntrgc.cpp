@@ -0,0 +1,166 @@
+/******************************************************************************
+ * File:    cntrgc.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.ContainerCollector
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement ContainerCollector class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#include "cntrgc.h"
+
+#include "str.h"
+
+#include <limits>
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+ContainerCollector::ContainerCollector(std::shared_ptr<DockerMng> _dckMng,
+                                       int _tickMs)
+    : dckMng(_dckMng), tickMs(_tickMs),
+      t0(std::chrono::steady_clock::now()), wheel(_tickMs, 0),
+      quit(false),
+      logger(Log::getLogger("cntrgc"))
+{
+}
+
+//----------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------
+ContainerCollector::~ContainerCollector()
+{
+    stop();
+}
+
+//----------------------------------------------------------------------
+// Method: start
+// Launches the collector thread
+//----------------------------------------------------------------------
+void ContainerCollector::start()
+{
+    if (collector.joinable()) { return; }
+    quit = false;
+    collector = std::thread(&ContainerCollector::run, this);
+}
+
+//----------------------------------------------------------------------
+// Method: stop
+// Stops the collector thread, and removes at once the containers still
+// pending (all of them have exited already)
+//----------------------------------------------------------------------
+void ContainerCollector::stop()
+{
+    if (! collector.joinable()) { return; }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        quit = true;
+    }
+    cv.notify_all();
+    collector.join();
+
+    std::vector<std::string> ids;
+    wheel.advance(std::numeric_limits<long long>::max() / 2, ids);
+    removeBatch(ids);
+}
+
+//----------------------------------------------------------------------
+// Method: schedule
+// Schedules the removal of the container after the given delay.  Can
+// be called from any thread
+//----------------------------------------------------------------------
+void ContainerCollector::schedule(const std::string & contId, int delayMs)
+{
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        wasEmpty = wheel.empty();
+        wheel.schedule(contId, nowMs() + delayMs);
+    }
+    logger.debug("Container %s scheduled for removal", contId.c_str());
+    if (wasEmpty) { cv.notify_one(); }
+}
+
+//----------------------------------------------------------------------
+// Method: run
+// Advances the wheel at each tick, while there are pending containers,
+// and removes the due ones (out of the lock)
+//----------------------------------------------------------------------
+void ContainerCollector::run()
+{
+    std::vector<std::string> due;
+    std::unique_lock<std::mutex> lock(mtx);
+    while (! quit) {
+        if (wheel.empty()) {
+            cv.wait(lock, [this]{ return quit || (! wheel.empty()); });
+        } else {
+            cv.wait_for(lock, std::chrono::milliseconds(tickMs));
+        }
+        if (quit) { break; }
+
+        wheel.advance(nowMs(), due);
+        if (due.empty()) { continue; }
+
+        lock.unlock();
+        removeBatch(due);
+        due.clear();
+        lock.lock();
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: nowMs
+// Returns the time elapsed since the creation of the collector
+//----------------------------------------------------------------------
+long long ContainerCollector::nowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>
+        (std::chrono::steady_clock::now() - t0).count();
+}
+
+//----------------------------------------------------------------------
+// Method: removeBatch
+// Removes the given containers with a single request to the manager
+//----------------------------------------------------------------------
+void ContainerCollector::removeBatch(std::vector<std::string> & ids)
+{
+    if (ids.empty()) { return; }
+    if (dckMng->removeBatch(ids)) {
+        logger.debug("Removed %d containers", (int)(ids.size()));
+    } else {
+        logger.warn("Couldn't remove some of the containers %s",
+                    str::join(ids, " ").c_str());
+    }
+}
@@ -0,0 +1,146 @@
+/******************************************************************************
+ * File:    cntrgc.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.ContainerCollector
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare ContainerCollector class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#ifndef CONTAINERCOLLECTOR_H
+#define CONTAINERCOLLECTOR_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//   - vector
+//   - memory
+//   - thread
+//   - mutex
+//   - condition_variable
+//   - chrono
+//------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+#include "dckmng.h"
+#include "timerwheel.h"
+#include "log.h"
+
+//==========================================================================
+// Class: ContainerCollector
+// Removes the exited containers of all the agents of the node, some
+// time after they have exited.  The removal times are kept in a timer
+// wheel, and all the containers due at a given tick are removed in one
+// batch, from the collector thread (with its own container manager)
+//==========================================================================
+class ContainerCollector {
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    ContainerCollector(std::shared_ptr<DockerMng> _dckMng, int _tickMs = 100);
+
+    //----------------------------------------------------------------------
+    // Destructor
+    //----------------------------------------------------------------------
+    virtual ~ContainerCollector();
+
+    //----------------------------------------------------------------------
+    // Method: start
+    //----------------------------------------------------------------------
+    void start();
+
+    //----------------------------------------------------------------------
+    // Method: stop
+    // Stops the collector thread, removing the pending containers
+    //----------------------------------------------------------------------
+    void stop();
+
+    //----------------------------------------------------------------------
+    // Method: schedule
+    // Schedules the removal of the container after the given delay
+    //----------------------------------------------------------------------
+    void schedule(const std::string & contId, int delayMs);
+
+private:
+    //----------------------------------------------------------------------
+    // Method: run
+    //----------------------------------------------------------------------
+    void run();
+
+    //----------------------------------------------------------------------
+    // Method: nowMs
+    //----------------------------------------------------------------------
+    long long nowMs();
+
+    //----------------------------------------------------------------------
+    // Method: removeBatch
+    //----------------------------------------------------------------------
+    void removeBatch(std::vector<std::string> & ids);
+
+private:
+    std::shared_ptr<DockerMng> dckMng;
+    int tickMs;
+
+    std::chrono::steady_clock::time_point t0;
+    TimerWheel<std::string> wheel;
+
+    bool quit;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread collector;
+
+    Logger logger;
+};
+
+#endif // CONTAINERCOLLECTOR_H
@@ -62,7 +62,7 @@ ContainerMng::ContainerMng(WorkArea & _wa) : DockerMng(_wa)
 bool ContainerMng::createContainer(std::string img, std::vector<std::string> opts,
                                    std::map<std::string, std::string> maps,
                                    std::string exe, std::vector<std::string> args,
-                                   std::string & containerId, string & cmd_line)
+                                   std::string & containerId, std::string & cmd_line)
 {
     static char fileIdTpl[] = "dockerId_XXXXXX";
 
@@ -149,6 +149,39 @@ bool ContainerMng::createContainer(std::string proc, std::string workDir,
     return (cnt.code() == 0);
 }
 
+//----------------------------------------------------------------------
+// Method: exec
+// Runs (detached) the requested application in a running container
+//----------------------------------------------------------------------
+bool ContainerMng::exec(std::string id, std::vector<std::string> opts,
+                        std::string exe, std::vector<std::string> args)
+{
+    procxx::process cnt("/usr/bin/docker", "exec", "--detach");
+    for (auto & o : opts) { cnt.add_argument(o); }
+    cnt.add_argument(id);
+    cnt.add_argument(exe);
+    for (auto & a : args) { cnt.add_argument(a); }
+
+    cnt.exec();
+    cnt.wait();
+    return (cnt.code() == 0);
+}
+
+//----------------------------------------------------------------------
+// Method: update
+// Updates the resources of a container
+//----------------------------------------------------------------------
+bool ContainerMng::update(std::string id, std::vector<std::string> opts)
+{
+    procxx::process cnt("/usr/bin/docker", "update");
+    for (auto & o : opts) { cnt.add_argument(o); }
+    cnt.add_argument(id);
+
+    cnt.exec();
+    cnt.wait();
+    return (cnt.code() == 0);
+}
+
 //----------------------------------------------------------------------
 // Method: getInfo
 // Retrieves information about running container
@@ -187,6 +220,28 @@ bool ContainerMng::getInfo(std::string id, std::stringstream & info)
     return (cntInspect.code() == 0);
 }
 
+//----------------------------------------------------------------------
+// Method: inspect
+// Retrieves the main inspection fields of the container
+//----------------------------------------------------------------------
+bool ContainerMng::inspect(std::string id, json & summary)
+{
+    static const std::string fmt("'{\"Id\":{{json .Id}}"
+                                 ",\"State\":{{json .State}}"
+                                 ",\"Path\":{{json .Path}}"
+                                 ",\"Args\":{{json .Args}}"
+                                 ",\"Config\":{{json .Config}}}'");
+    std::stringstream info;
+    info.str(fmt);
+    if (! getInfo(id, info)) { return false; }
+    try {
+        summary = json::parse(info.str());
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
 //----------------------------------------------------------------------
 // Method: kill
 // Kill a running container
@@ -240,3 +295,16 @@ bool ContainerMng::remove(std::string id)
     return (srvRm.code() == 0);
 }
 
+//----------------------------------------------------------------------
+// Method: removeBatch
+// Removes a set of exited containers, with a single docker rm
+//----------------------------------------------------------------------
+bool ContainerMng::removeBatch(std::vector<std::string> & ids)
+{
+    if (ids.empty()) { return true; }
+    procxx::process srvRm("docker", "rm");
+    for (auto & id : ids) { srvRm.add_argument(id); }
+    srvRm.exec();
+    srvRm.wait();
+    return (srvRm.code() == 0);
+}
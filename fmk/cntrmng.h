@@ -83,7 +83,7 @@ public:
     virtual bool createContainer(std::string img, std::vector<std::string> opts,
                                  std::map<std::string, std::string> maps,
                                  std::string exe, std::vector<std::string> args,
-                                 std::string & containerId, string & cmd_line);
+                                 std::string & containerId, std::string & cmd_line);
 
     //----------------------------------------------------------------------
     // Method: createContainer
@@ -92,12 +92,31 @@ public:
     virtual bool createContainer(std::string proc, std::string workDir,
                                  std::string & containerId);
 
+    //----------------------------------------------------------------------
+    // Method: exec
+    // Runs (detached) the requested application in a running container
+    //----------------------------------------------------------------------
+    virtual bool exec(std::string id, std::vector<std::string> opts,
+                      std::string exe, std::vector<std::string> args);
+
+    //----------------------------------------------------------------------
+    // Method: update
+    // Updates the resources of a container
+    //----------------------------------------------------------------------
+    virtual bool update(std::string id, std::vector<std::string> opts);
+
     //----------------------------------------------------------------------
     // Method: getInfo
     // Retrieves information about running container
     //----------------------------------------------------------------------
     virtual bool getInfo(std::string id, std::stringstream & info);
 
+    //----------------------------------------------------------------------
+    // Method: inspect
+    // Retrieves the main inspection fields of the container
+    //----------------------------------------------------------------------
+    virtual bool inspect(std::string id, json & summary);
+
     //----------------------------------------------------------------------
     // Method: kill
     // Kill running container
@@ -110,6 +129,12 @@ public:
     //----------------------------------------------------------------------
     virtual bool remove(std::string id);
 
+    //----------------------------------------------------------------------
+    // Method: removeBatch
+    // Removes a set of exited containers, with a single docker rm
+    //----------------------------------------------------------------------
+    virtual bool removeBatch(std::vector<std::string> & ids);
+
 };
 
 #endif  /* CNTRMNG_H */
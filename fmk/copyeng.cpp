@@ -0,0 +1,373 @@
+/******************************************************************************
+ * File:    copyeng.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.CopyEngine
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement CopyEngine class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#include "copyeng.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+
+std::mutex CopyEngine::mtx;
+CopyEngine::MethodMetrics CopyEngine::methodMetrics[CopyEngine::NUM_OF_METHODS] = {};
+
+const off_t CopyEngine::ParallelThreshold = 256 * 1024 * 1024;
+const off_t CopyEngine::ChunkSize = 64 * 1024 * 1024;
+const int   CopyEngine::MaxCopyThreads = 4;
+
+static const char * CopyMethodName[CopyEngine::NUM_OF_METHODS] =
+    {"reflink", "copy_file_range", "sendfile", "parallel", "userspace"};
+
+//----------------------------------------------------------------------
+// Function: kernelCopyRange
+// copy_file_range system call, which may not have a wrapper in libc
+//----------------------------------------------------------------------
+static ssize_t kernelCopyRange(int sfd, loff_t * soff, int dfd, loff_t * doff,
+                               size_t len)
+{
+#ifdef __NR_copy_file_range
+    return syscall(__NR_copy_file_range, sfd, soff, dfd, doff, len, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+//----------------------------------------------------------------------
+// Function: isUnsupported
+// Errors meaning that a copy method cannot be used for these files
+//----------------------------------------------------------------------
+static bool isUnsupported(int err)
+{
+    return ((err == ENOSYS) || (err == EXDEV) || (err == EINVAL) ||
+            (err == EOPNOTSUPP) || (err == ENOTSUP) || (err == ENOTTY) ||
+            (err == EBADF));
+}
+
+//----------------------------------------------------------------------
+// Method: copy
+// Copies the file, returning 0 on success, or -1 with errno set.  The
+// target file is removed if the copy fails
+//----------------------------------------------------------------------
+int CopyEngine::copy(const std::string & from, const std::string & to)
+{
+    int sfd = open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if (sfd < 0) { return -1; }
+    struct stat st;
+    if (fstat(sfd, &st) != 0) {
+        int err = errno;
+        close(sfd);
+        errno = err;
+        return -1;
+    }
+    int dfd = open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                   st.st_mode & 07777);
+    if (dfd < 0) {
+        int err = errno;
+        close(sfd);
+        errno = err;
+        return -1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    CopyMethod m = REFLINK;
+    bool ok = reflink(sfd, dfd);
+    if (! ok) {
+        if ((st.st_size >= ParallelThreshold) && isNetworkFs(dfd)) {
+            m = PARALLEL;
+            ok = parallelCopy(sfd, dfd, st.st_size);
+        } else {
+            ok = sequentialCopy(sfd, dfd, st.st_size, m);
+        }
+    }
+    int err = errno;
+    if (close(dfd) != 0) {
+        if (ok) { err = errno; }
+        ok = false;
+    }
+    close(sfd);
+
+    if (! ok) {
+        (void)unlink(to.c_str());
+        errno = err;
+        return -1;
+    }
+    account(m, st.st_size,
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// Method: metrics
+// Returns, for each method, the number of copies, the bytes copied
+// and the mean rate in bytes/s
+//----------------------------------------------------------------------
+json CopyEngine::metrics()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    json j = json::object();
+    for (int i = 0; i < NUM_OF_METHODS; ++i) {
+        MethodMetrics & mm = methodMetrics[i];
+        if (mm.copies < 1) { continue; }
+        double rate = (mm.seconds > 0.) ? (mm.bytes / mm.seconds) : 0.;
+        j[CopyMethodName[i]] = {{"copies", mm.copies}, {"bytes", mm.bytes},
+                                {"bytesPerSec", (long long)(rate)}};
+    }
+    return j;
+}
+
+//----------------------------------------------------------------------
+// Method: reflink
+// Makes the target share the data blocks of the source, on the
+// filesystems that support it (same filesystem only)
+//----------------------------------------------------------------------
+bool CopyEngine::reflink(int sfd, int dfd)
+{
+#ifdef FICLONE
+    return (ioctl(dfd, FICLONE, sfd) == 0);
+#else
+    (void)sfd;
+    (void)dfd;
+    return false;
+#endif
+}
+
+//----------------------------------------------------------------------
+// Method: sequentialCopy
+// Copies the file with copy_file_range, or sendfile if not possible
+// (e.g. across filesystems in old kernels), or read/write otherwise
+//----------------------------------------------------------------------
+bool CopyEngine::sequentialCopy(int sfd, int dfd, off_t size, CopyMethod & m)
+{
+    off_t done = 0;
+
+    m = COPY_RANGE;
+    while (done < size) {
+        ssize_t n = kernelCopyRange(sfd, nullptr, dfd, nullptr,
+                                    (size_t)(size - done));
+        if (n > 0) {
+            done += n;
+            continue;
+        }
+        if (n == 0) {
+            // Nothing moved at all: let the next method try
+            if (done == 0) { break; }
+            errno = EIO;  // The source is shorter than it was
+            return false;
+        }
+        if (errno == EINTR) { continue; }
+        if ((done > 0) || (! isUnsupported(errno))) { return false; }
+        break;
+    }
+    if (done >= size) { return true; }
+
+    m = SENDFILE;
+    while (done < size) {
+        ssize_t n = sendfile(dfd, sfd, nullptr, (size_t)(size - done));
+        if (n > 0) {
+            done += n;
+            continue;
+        }
+        if (n == 0) {
+            // Nothing moved at all: let the next method try
+            if (done == 0) { break; }
+            errno = EIO;  // The source is shorter than it was
+            return false;
+        }
+        if (errno == EINTR) { continue; }
+        if ((done > 0) || (! isUnsupported(errno))) { return false; }
+        break;
+    }
+    if (done >= size) { return true; }
+
+    m = USERSPACE;
+    return rangeCopy(sfd, dfd, 0, size, false);
+}
+
+//----------------------------------------------------------------------
+// Method: parallelCopy
+// Copies the file in chunks, taken by several threads, so that the
+// latency of the network filesystem is overlapped
+//----------------------------------------------------------------------
+bool CopyEngine::parallelCopy(int sfd, int dfd, off_t size)
+{
+    if (ftruncate(dfd, size) != 0) { return false; }
+
+    off_t numOfChunks = (size + ChunkSize - 1) / ChunkSize;
+    int numOfThreads = (int)(std::min((off_t)(MaxCopyThreads), numOfChunks));
+    std::atomic<off_t> nextChunk(0);
+    std::atomic<bool> ok(true);
+    std::atomic<int> err(0);
+
+    auto worker = [&]() {
+        bool useKernel = true;
+        off_t chunk;
+        while (ok && ((chunk = nextChunk++) < numOfChunks)) {
+            off_t off = chunk * ChunkSize;
+            off_t len = std::min(ChunkSize, size - off);
+            if (useKernel && (! rangeCopy(sfd, dfd, off, len, true))) {
+                if (! isUnsupported(errno)) {
+                    err = errno;
+                    ok = false;
+                    return;
+                }
+                useKernel = false;
+            }
+            if ((! useKernel) && (! rangeCopy(sfd, dfd, off, len, false))) {
+                err = errno;
+                ok = false;
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < numOfThreads; ++i) { threads.emplace_back(worker); }
+    worker();
+    for (auto & t: threads) { t.join(); }
+
+    if (! ok) { errno = err; }
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// Method: rangeCopy
+// Copies a range of the file at the same offset in the target, with
+// copy_file_range or with pread/pwrite.  A range copied partially by
+// the kernel is completed with pread/pwrite
+//----------------------------------------------------------------------
+bool CopyEngine::rangeCopy(int sfd, int dfd, off_t off, off_t len,
+                           bool useKernel)
+{
+    off_t end = off + len;
+
+    if (useKernel) {
+        loff_t soff = off;
+        loff_t doff = off;
+        while (soff < end) {
+            ssize_t n = kernelCopyRange(sfd, &soff, dfd, &doff,
+                                        (size_t)(end - soff));
+            if (n > 0) { continue; }
+            if (n == 0) { break; }
+            if (errno == EINTR) { continue; }
+            if (soff == off) { return false; }
+            break;
+        }
+        if (soff >= end) { return true; }
+        off = soff;
+    }
+
+    std::vector<char> buf(1024 * 1024);
+    while (off < end) {
+        ssize_t n = pread(sfd, buf.data(),
+                          (size_t)(std::min((off_t)(buf.size()), end - off)), off);
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            return false;
+        }
+        if (n == 0) {
+            errno = EIO;  // The source is shorter than it was
+            return false;
+        }
+        ssize_t w = 0;
+        while (w < n) {
+            ssize_t k = pwrite(dfd, buf.data() + w, (size_t)(n - w), off + w);
+            if (k < 0) {
+                if (errno == EINTR) { continue; }
+                return false;
+            }
+            w += k;
+        }
+        off += n;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: isNetworkFs
+// Tells whether the file is in a network or cluster filesystem
+//----------------------------------------------------------------------
+bool CopyEngine::isNetworkFs(int fd)
+{
+    static const unsigned long networkFs[] = {
+        0x6969,       // NFS
+        0xFF534D42,   // CIFS
+        0xFE534D42,   // SMB2
+        0x517B,       // SMB
+        0x65735546,   // FUSE
+        0x0BD00BD0,   // Lustre
+        0x47504653,   // GPFS
+        0x00C36400,   // CephFS
+        0x013111A8,   // IBRIX
+        0x19830326,   // FhGFS / BeeGFS
+    };
+
+    struct statfs sfs;
+    if (fstatfs(fd, &sfs) != 0) { return false; }
+    unsigned long type = (unsigned long)(sfs.f_type) & 0xFFFFFFFFUL;
+    return (std::find(std::begin(networkFs), std::end(networkFs), type) !=
+            std::end(networkFs));
+}
+
+//----------------------------------------------------------------------
+// Method: account
+// Adds a copy to the metrics of its method
+//----------------------------------------------------------------------
+void CopyEngine::account(CopyMethod m, off_t bytes, double secs)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    MethodMetrics & mm = methodMetrics[m];
+    mm.copies++;
+    mm.bytes += bytes;
+    mm.seconds += secs;
+}
@@ -0,0 +1,147 @@
+/******************************************************************************
+ * File:    copyeng.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.CopyEngine
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare CopyEngine class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#ifndef COPYENGINE_H
+#define COPYENGINE_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//   - mutex
+//------------------------------------------------------------
+#include <string>
+#include <mutex>
+#include <sys/types.h>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+#include "types.h"
+
+//==========================================================================
+// Class: CopyEngine
+// Copies files letting the kernel do the work: a reflink is tried
+// first, then copy_file_range (or sendfile), and read/write only as a
+// last resort.  Large files on network filesystems are copied in
+// chunks by several threads.  The bytes copied and the time spent are
+// accounted for each method
+//==========================================================================
+class CopyEngine {
+
+public:
+    enum CopyMethod {
+        REFLINK,
+        COPY_RANGE,
+        SENDFILE,
+        PARALLEL,
+        USERSPACE,
+        NUM_OF_METHODS
+    };
+
+    //----------------------------------------------------------------------
+    // Method: copy
+    // Copies the file, returning 0 on success, or -1 with errno set
+    //----------------------------------------------------------------------
+    static int copy(const std::string & from, const std::string & to);
+
+    //----------------------------------------------------------------------
+    // Method: metrics
+    // Returns, for each method, the number of copies, the bytes copied
+    // and the mean rate in bytes/s
+    //----------------------------------------------------------------------
+    static json metrics();
+
+private:
+    //----------------------------------------------------------------------
+    // Method: reflink
+    //----------------------------------------------------------------------
+    static bool reflink(int sfd, int dfd);
+
+    //----------------------------------------------------------------------
+    // Method: sequentialCopy
+    //----------------------------------------------------------------------
+    static bool sequentialCopy(int sfd, int dfd, off_t size, CopyMethod & m);
+
+    //----------------------------------------------------------------------
+    // Method: parallelCopy
+    //----------------------------------------------------------------------
+    static bool parallelCopy(int sfd, int dfd, off_t size);
+
+    //----------------------------------------------------------------------
+    // Method: rangeCopy
+    //----------------------------------------------------------------------
+    static bool rangeCopy(int sfd, int dfd, off_t off, off_t len,
+                          bool useKernel);
+
+    //----------------------------------------------------------------------
+    // Method: isNetworkFs
+    //----------------------------------------------------------------------
+    static bool isNetworkFs(int fd);
+
+    //----------------------------------------------------------------------
+    // Method: account
+    //----------------------------------------------------------------------
+    static void account(CopyMethod m, off_t bytes, double secs);
+
+private:
+    struct MethodMetrics {
+        long long copies;
+        long long bytes;
+        double    seconds;
+    };
+
+    static std::mutex mtx;
+    static MethodMetrics methodMetrics[NUM_OF_METHODS];
+
+    static const off_t ParallelThreshold;
+    static const off_t ChunkSize;
+    static const int   MaxCopyThreads;
+};
+
+#endif // COPYENGINE_H
@@ -0,0 +1,208 @@
+/******************************************************************************
+ * File:    cpuinv.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.CpuInventory
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement CpuInventory class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#include "cpuinv.h"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <cstdlib>
+#include <cstring>
+
+#include <dirent.h>
+#include <sched.h>
+
+//----------------------------------------------------------------------
+// Constructor
+// Discovers the CPUs the process may run on, and their NUMA nodes.  If
+// there is no NUMA information, all of them are placed in node 0
+//----------------------------------------------------------------------
+CpuInventory::CpuInventory(std::string restrictTo)
+    : logger(Log::getLogger("cpuinv"))
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) { CPU_SET(c, &allowed); }
+    }
+    if (! restrictTo.empty()) {
+        cpu_set_t restricted;
+        CPU_ZERO(&restricted);
+        for (int c: parseList(restrictTo)) { CPU_SET(c, &restricted); }
+        CPU_AND(&allowed, &allowed, &restricted);
+    }
+
+    static const std::string nodesDir("/sys/devices/system/node");
+    DIR * dir = opendir(nodesDir.c_str());
+    struct dirent * ent;
+    while ((dir != nullptr) && ((ent = readdir(dir)) != nullptr)) {
+        if ((std::strncmp(ent->d_name, "node", 4) != 0) ||
+            (ent->d_name[4] < '0') || (ent->d_name[4] > '9')) { continue; }
+        std::ifstream ifs(nodesDir + "/" + ent->d_name + "/cpulist");
+        std::string list;
+        if (! std::getline(ifs, list)) { continue; }
+
+        NumaNode node {std::atoi(ent->d_name + 4), {}};
+        for (int c: parseList(list)) {
+            if (CPU_ISSET(c, &allowed)) { node.cpus.push_back(c); }
+        }
+        if (! node.cpus.empty()) { nodes.push_back(node); }
+    }
+    if (dir != nullptr) { closedir(dir); }
+
+    if (nodes.empty()) {
+        NumaNode node {0, {}};
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &allowed)) { node.cpus.push_back(c); }
+        }
+        nodes.push_back(node);
+    }
+
+    std::sort(nodes.begin(), nodes.end(),
+              [](const NumaNode & a, const NumaNode & b) { return a.id < b.id; });
+
+    logger.info("%d CPUs available in %d NUMA nodes", numOfCpus(), numOfNodes());
+}
+
+//----------------------------------------------------------------------
+// Method: numOfCpus
+//----------------------------------------------------------------------
+int CpuInventory::numOfCpus() const
+{
+    int n = 0;
+    for (auto & node: nodes) { n += (int)(node.cpus.size()); }
+    return n;
+}
+
+//----------------------------------------------------------------------
+// Method: partition
+// Splits the CPUs into the given number of disjoint sets, taking them
+// in order, node by node, so that a set only spans several NUMA nodes
+// when the CPUs per set do not divide the CPUs per node.  If there are
+// more slots than CPUs, the sets are reused (no longer disjoint)
+//----------------------------------------------------------------------
+std::vector<CpuSlot> CpuInventory::partition(int numOfSlots)
+{
+    std::vector<CpuSlot> slots;
+    int total = numOfCpus();
+    if ((numOfSlots < 1) || (total < 1)) { return slots; }
+
+    std::vector<std::pair<int, int>> cpus;  // (cpu, node index)
+    for (size_t n = 0; n < nodes.size(); ++n) {
+        for (int c: nodes.at(n).cpus) { cpus.push_back(std::make_pair(c, n)); }
+    }
+
+    int perSlot = std::max(1, total / numOfSlots);
+    int extra = (total > numOfSlots) ? (total % numOfSlots) : 0;
+    if (numOfSlots > total) {
+        logger.warn("Only %d CPUs for %d container slots: sets will be shared",
+                    total, numOfSlots);
+    }
+
+    int next = 0;
+    for (int s = 0; s < numOfSlots; ++s) {
+        int size = perSlot + ((s < extra) ? 1 : 0);
+        std::vector<int> slotCpus;
+        std::set<int> slotNodes;
+        for (int i = 0; i < size; ++i, ++next) {
+            auto & p = cpus.at(next % total);
+            slotCpus.push_back(p.first);
+            slotNodes.insert(p.second);
+        }
+        std::sort(slotCpus.begin(), slotCpus.end());
+
+        std::vector<int> mems, nodeCpus;
+        for (int n: slotNodes) {
+            mems.push_back(nodes.at(n).id);
+            nodeCpus.insert(nodeCpus.end(), nodes.at(n).cpus.begin(),
+                            nodes.at(n).cpus.end());
+        }
+        std::sort(nodeCpus.begin(), nodeCpus.end());
+
+        slots.push_back(CpuSlot {toList(slotCpus), toList(mems), toList(nodeCpus)});
+    }
+    return slots;
+}
+
+//----------------------------------------------------------------------
+// Method: parseList
+// Parses a CPU list (i.e.: 0-3,8,10-11)
+//----------------------------------------------------------------------
+std::vector<int> CpuInventory::parseList(const std::string & list)
+{
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) { comma = list.size(); }
+        std::string item = list.substr(pos, comma - pos);
+        pos = comma + 1;
+        if (item.empty()) { continue; }
+
+        size_t dash = item.find('-');
+        int from = std::atoi(item.c_str());
+        int to = ((dash == std::string::npos) ? from :
+                  std::atoi(item.c_str() + dash + 1));
+        for (int c = from; (c <= to) && (c < CPU_SETSIZE); ++c) {
+            if (c >= 0) { cpus.push_back(c); }
+        }
+    }
+    return cpus;
+}
+
+//----------------------------------------------------------------------
+// Method: toList
+// Builds a CPU list from a sorted set of CPU numbers
+//----------------------------------------------------------------------
+std::string CpuInventory::toList(const std::vector<int> & cpus)
+{
+    std::string list;
+    size_t i = 0;
+    while (i < cpus.size()) {
+        size_t j = i;
+        while ((j + 1 < cpus.size()) && (cpus.at(j + 1) == cpus.at(j) + 1)) { ++j; }
+        if (! list.empty()) { list += ","; }
+        list += std::to_string(cpus.at(i));
+        if (j > i) { list += "-" + std::to_string(cpus.at(j)); }
+        i = j + 1;
+    }
+    return list;
+}
@@ -0,0 +1,122 @@
+/******************************************************************************
+ * File:    cpuinv.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.CpuInventory
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare CpuInventory class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#ifndef CPUINVENTORY_H
+#define CPUINVENTORY_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//   - vector
+//------------------------------------------------------------
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+#include "types.h"
+#include "log.h"
+
+//==========================================================================
+// Class: CpuInventory
+// CPUs available to the process, grouped by NUMA node, as found in
+// /sys/devices/system/node.  They can be partitioned into disjoint
+// sets, one per container slot, keeping each set within a NUMA node
+// whenever the number of CPUs allows it
+//==========================================================================
+class CpuInventory {
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    // Discovers the CPUs, optionally restricted to the given list
+    //----------------------------------------------------------------------
+    CpuInventory(std::string restrictTo = std::string(""));
+
+    //----------------------------------------------------------------------
+    // Method: numOfCpus
+    //----------------------------------------------------------------------
+    int numOfCpus() const;
+
+    //----------------------------------------------------------------------
+    // Method: numOfNodes
+    //----------------------------------------------------------------------
+    int numOfNodes() const { return (int)(nodes.size()); }
+
+    //----------------------------------------------------------------------
+    // Method: partition
+    // Splits the CPUs into the given number of disjoint sets
+    //----------------------------------------------------------------------
+    std::vector<CpuSlot> partition(int numOfSlots);
+
+    //----------------------------------------------------------------------
+    // Method: parseList
+    // Parses a CPU list (i.e.: 0-3,8,10-11)
+    //----------------------------------------------------------------------
+    static std::vector<int> parseList(const std::string & list);
+
+    //----------------------------------------------------------------------
+    // Method: toList
+    // Builds a CPU list from a sorted set of CPU numbers
+    //----------------------------------------------------------------------
+    static std::string toList(const std::vector<int> & cpus);
+
+private:
+    struct NumaNode {
+        int              id;
+        std::vector<int> cpus;
+    };
+
+    std::vector<NumaNode> nodes;
+
+    Logger logger;
+};
+
+#endif // CPUINVENTORY_H
@@ -39,22 +39,14 @@
  ******************************************************************************/
 
 #include "cs.h"
-#include <chrono>
 
 //----------------------------------------------------------------------
 // Constructor
 //----------------------------------------------------------------------
-ContainerSpectrum::ContainerSpectrum()
-    : savedSpec({{"ABORTED", 0},
-                  {"ARCHIVED", 0},
-                  {"FAILED", 0},
-                  {"FINISHED", 0},
-                  {"PAUSED", 0},
-                  {"RUNNING", 0},
-                  {"SCHEDULED", 0},
-                  {"STOPPED", 0}})
+ContainerSpectrum::ContainerSpectrum(size_t _sz)
+    : ring(_sz), next(0), len(0), counts {}, changed(false)
 {
-    cnts.setSize(40);
+    index.reserve(_sz * 2);
 }
 
 //----------------------------------------------------------------------
@@ -66,32 +58,51 @@ ContainerSpectrum::~ContainerSpectrum()
 
 //----------------------------------------------------------------------
 // Method: append
-// Append container and status to the list
+// Sets the status of the container, adding it if not yet there.  When
+// the ring is full, the oldest container leaves it, but it is still
+// counted with its last status
 //----------------------------------------------------------------------
-void ContainerSpectrum::append(string cont, string status)
+void ContainerSpectrum::append(const string & cont, TaskStatusEnum status)
 {
-    if (! cnts.find(cont)) {
-        string oldCont = cnts.put(string(cont));
-        if (!oldCont.empty()) {
-            //std::cerr << "Appending " << cont
-            //          << ", returned " << oldCont << '\n';
-            auto cntIt = cntStatus.find(oldCont);
-            string oldStatus = cntIt->second;
-            savedSpec[oldStatus] = savedSpec[oldStatus] + 1;
-            cntStatus.erase(cntIt);
+    int idx = SpectrumUpdate::index(status);
+
+    auto it = index.find(cont);
+    if (it != index.end()) {
+        Entry & e = ring[it->second];
+        if (e.idx == idx) { return; }
+        counts.counts[e.idx]--;
+        e.idx = idx;
+    } else {
+        if (len == ring.size()) {
+            index.erase(ring[next].cont);
+        } else {
+            ++len;
         }
+        ring[next] = Entry {cont, idx};
+        index[cont] = next;
+        next = (next + 1) % ring.size();
     }
-    cntStatus[cont] = status;
+    counts.counts[idx]++;
+    changed = true;
 }
 
 //----------------------------------------------------------------------
-// Method: spectrum
+// Method: takeUpdate
+// Copies the counts, if they changed since they were last taken
 //----------------------------------------------------------------------
-CntrSpectrum ContainerSpectrum::spectrum()
+bool ContainerSpectrum::takeUpdate(SpectrumUpdate & upd)
 {
-    CntrSpectrum spec(savedSpec);
-    for (auto & kv: cntStatus) {
-        spec[kv.second] = spec[kv.second] + 1;
-    }
-    return spec;
+    if (! changed) { return false; }
+    upd = counts;
+    changed = false;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: setChanged
+// Marks the counts as changed, so that they are taken again
+//----------------------------------------------------------------------
+void ContainerSpectrum::setChanged()
+{
+    changed = true;
 }
@@ -47,8 +47,13 @@
 
 //------------------------------------------------------------
 // Topic: System headers
-//   - iostream
+//   - string
+//   - vector
+//   - unordered_map
 //------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <unordered_map>
 
 //------------------------------------------------------------
 // Topic: External packages
@@ -58,10 +63,15 @@
 // Topic: Project headers
 //------------------------------------------------------------
 #include "types.h"
-#include "fifo.h"
+#include "agentmsg.h"
 
 //==========================================================================
 // Class: ContainerSpectrum
+// Number of containers of an agent in each of the task states.  The
+// last containers are kept in a fixed ring, indexed by container id,
+// so that their status can be updated; older containers keep the
+// status they had when they left the ring.  The counts are updated
+// incrementally, and are only taken when they changed
 //==========================================================================
 class ContainerSpectrum {
 
@@ -69,7 +79,7 @@ public:
     //----------------------------------------------------------------------
     // Constructor
     //----------------------------------------------------------------------
-    ContainerSpectrum();
+    ContainerSpectrum(size_t _sz = 40);
 
     //----------------------------------------------------------------------
     // Destructor
@@ -79,18 +89,35 @@ public:
 public:
     //----------------------------------------------------------------------
     // Method: append
+    // Sets the status of the container, adding it if not yet there
     //----------------------------------------------------------------------
-    void append(string cont, string status);
+    void append(const string & cont, TaskStatusEnum status);
 
     //----------------------------------------------------------------------
-    // Method: spectrum
+    // Method: takeUpdate
+    // Copies the counts, if they changed since they were last taken
     //----------------------------------------------------------------------
-    CntrSpectrum spectrum();
+    bool takeUpdate(SpectrumUpdate & upd);
+
+    //----------------------------------------------------------------------
+    // Method: setChanged
+    // Marks the counts as changed, so that they are taken again
+    //----------------------------------------------------------------------
+    void setChanged();
 
 private:
-    FiFo<string> cnts;
-    map<string, string> cntStatus;
-    CntrSpectrum savedSpec;
+    struct Entry {
+        string cont;
+        int    idx;
+    };
+
+    vector<Entry> ring;
+    size_t next;
+    size_t len;
+    std::unordered_map<string, size_t> index;
+
+    SpectrumUpdate counts;
+    bool changed;
 };
 
 #endif // CONTAINERSPECTRUM_H
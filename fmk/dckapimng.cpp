@@ -0,0 +1,351 @@
+/******************************************************************************
+ * File:    dckapimng.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.DockerApiMng
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement DockerApiMng class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#include "dckapimng.h"
+
+#include "str.h"
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+DockerApiMng::DockerApiMng(WorkArea & _wa, std::string sockPath)
+    : DockerMng(_wa), http(sockPath),
+      logger(Log::getLogger("dckapi"))
+{
+}
+
+//----------------------------------------------------------------------
+// Method: createContainer
+// Creates and starts a container that executes the requested application
+//----------------------------------------------------------------------
+bool DockerApiMng::createContainer(std::string img, std::vector<std::string> opts,
+                                   std::map<std::string, std::string> maps,
+                                   std::string exe, std::vector<std::string> args,
+                                   std::string & containerId, std::string & cmd_line)
+{
+    json req;
+    std::string name;
+    std::string path("/containers/create");
+
+    if (! buildCreateRequest(img, opts, maps, exe, args, req, name)) {
+        cmd_line = "Invalid options: " + str::join(opts, " ");
+        return false;
+    }
+    if (! name.empty()) { path += "?name=" + name; }
+
+    std::string body = req.dump();
+    cmd_line = "POST " + path + " " + body;
+
+    std::string resp;
+    json created;
+    if ((! call("POST", path, body, resp, {201})) ||
+        (! parseResponse(path, resp, created))) { return false; }
+    containerId = created.is_object() ? created.value("Id", "") : "";
+    if (containerId.empty()) {
+        logger.error("Docker API POST %s returned no container id", path.c_str());
+        return false;
+    }
+
+    // A container that cannot be started is not tracked by anyone, so
+    // it is removed at once
+    if (! call("POST", "/containers/" + containerId + "/start", "", resp,
+               {204, 304})) {
+        if (! call("DELETE", "/containers/" + containerId + "?force=1", "",
+                   resp, {204, 404})) {
+            logger.warn("Couldn't remove container %s", containerId.c_str());
+        }
+        containerId.clear();
+        return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: exec
+// Creates and starts (detached) an exec instance in a running container
+//----------------------------------------------------------------------
+bool DockerApiMng::exec(std::string id, std::vector<std::string> opts,
+                        std::string exe, std::vector<std::string> args)
+{
+    json req = {{"AttachStdout", false}, {"AttachStderr", false}};
+    req["Cmd"] = json::array({exe});
+    for (auto & a: args) { req["Cmd"].push_back(a); }
+
+    json env = json::array();
+    for (size_t i = 0; i + 1 < opts.size(); i += 2) {
+        const std::string & opt = opts.at(i);
+        const std::string & val = opts.at(i + 1);
+        if ((opt == "--workdir") || (opt == "-w")) {
+            req["WorkingDir"] = val;
+        } else if ((opt == "--env") || (opt == "-e")) {
+            env.push_back(val);
+        } else if ((opt == "--user") || (opt == "-u")) {
+            req["User"] = val;
+        } else {
+            logger.error("Unsupported exec option %s", opt.c_str());
+            return false;
+        }
+    }
+    req["Env"] = env;
+
+    std::string resp;
+    std::string path("/containers/" + id + "/exec");
+    json created;
+    if ((! call("POST", path, req.dump(), resp, {201})) ||
+        (! parseResponse(path, resp, created))) {
+        return false;
+    }
+    std::string execId = created.is_object() ? created.value("Id", "") : "";
+    if (execId.empty()) {
+        logger.error("Docker API POST %s returned no exec id", path.c_str());
+        return false;
+    }
+
+    return call("POST", "/exec/" + execId + "/start", "{\"Detach\":true}",
+                resp, {200});
+}
+
+//----------------------------------------------------------------------
+// Method: update
+// Updates the CPU sets of a container
+//----------------------------------------------------------------------
+bool DockerApiMng::update(std::string id, std::vector<std::string> opts)
+{
+    json req = json::object();
+    for (size_t i = 0; i + 1 < opts.size(); i += 2) {
+        const std::string & opt = opts.at(i);
+        if (opt == "--cpuset-cpus") {
+            req["CpusetCpus"] = opts.at(i + 1);
+        } else if (opt == "--cpuset-mems") {
+            req["CpusetMems"] = opts.at(i + 1);
+        } else {
+            logger.error("Unsupported update option %s", opt.c_str());
+            return false;
+        }
+    }
+
+    std::string resp;
+    return call("POST", "/containers/" + id + "/update", req.dump(), resp, {200});
+}
+
+//----------------------------------------------------------------------
+// Method: getInfo
+// Retrieves the complete inspection information of the container
+//----------------------------------------------------------------------
+bool DockerApiMng::getInfo(std::string id, std::stringstream & info)
+{
+    std::string resp;
+    bool ok = call("GET", "/containers/" + id + "/json", "", resp, {200});
+    info.str(ok ? resp : "");
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// Method: inspect
+// Retrieves the main inspection fields of the container
+//----------------------------------------------------------------------
+bool DockerApiMng::inspect(std::string id, json & summary)
+{
+    std::string resp;
+    std::string path("/containers/" + id + "/json");
+    json full;
+    if ((! call("GET", path, "", resp, {200})) ||
+        (! parseResponse(path, resp, full)) || (! full.is_object())) {
+        return false;
+    }
+    summary = json::object();
+    for (auto & key: {"Id", "State", "Path", "Args", "Config"}) {
+        summary[key] = full.count(key) ? full[key] : json();
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: kill
+// Kill a running container
+//----------------------------------------------------------------------
+bool DockerApiMng::kill(std::string id)
+{
+    std::string resp;
+    return call("POST", "/containers/" + id + "/kill", "", resp, {204});
+}
+
+//----------------------------------------------------------------------
+// Method: remove
+// Remove a stopped container
+//----------------------------------------------------------------------
+bool DockerApiMng::remove(std::string id)
+{
+    std::string resp;
+    return call("DELETE", "/containers/" + id, "", resp, {204});
+}
+
+//----------------------------------------------------------------------
+// Method: getContainerList
+// Retrieves list of container ids in the form of a vector
+//----------------------------------------------------------------------
+bool DockerApiMng::getContainerList(std::vector<std::string> & contList)
+{
+    std::string resp;
+    std::string path("/containers/json?all=1");
+    json list;
+    if ((! call("GET", path, "", resp, {200})) ||
+        (! parseResponse(path, resp, list)) || (! list.is_array())) {
+        return false;
+    }
+    for (auto & c: list) {
+        if (! c.is_object()) { continue; }
+        std::string cid = c.value("Id", "");
+        if (! cid.empty()) { contList.push_back(cid.substr(0, 12)); }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: buildCreateRequest
+// Translates docker run options into a container creation request.
+// Only the options used by the QPF are supported
+//----------------------------------------------------------------------
+bool DockerApiMng::buildCreateRequest(std::string & img,
+                                      std::vector<std::string> & opts,
+                                      std::map<std::string, std::string> & maps,
+                                      std::string & exe,
+                                      std::vector<std::string> & args,
+                                      json & req, std::string & name)
+{
+    json hostCfg = {{"PublishAllPorts", true}, {"Privileged", true}};
+    json env = json::array();
+    json binds = json::array();
+    json labels = json::object();
+
+    req["Image"] = img;
+    req["Cmd"] = json::array({exe});
+    for (auto & a: args) { req["Cmd"].push_back(a); }
+
+    for (auto & kv: maps) { binds.push_back(kv.first + ":" + kv.second); }
+
+    for (size_t i = 0; i < opts.size(); ++i) {
+        std::string opt = opts.at(i);
+        std::string val;
+        size_t eq = opt.find('=');
+        if (opt == "--rm") {
+            hostCfg["AutoRemove"] = true;
+            continue;
+        } else if ((opt.compare(0, 2, "--") == 0) && (eq != std::string::npos)) {
+            val = opt.substr(eq + 1);
+            opt = opt.substr(0, eq);
+        } else if (i + 1 < opts.size()) {
+            val = opts.at(++i);
+        } else {
+            logger.error("Container option %s needs a value", opt.c_str());
+            return false;
+        }
+
+        if ((opt == "--workdir") || (opt == "-w")) {
+            req["WorkingDir"] = val;
+        } else if ((opt == "--env") || (opt == "-e")) {
+            env.push_back(val);
+        } else if ((opt == "--volume") || (opt == "-v")) {
+            binds.push_back(val);
+        } else if ((opt == "--label") || (opt == "-l")) {
+            size_t p = val.find('=');
+            labels[val.substr(0, p)] = ((p == std::string::npos) ? "" :
+                                        val.substr(p + 1));
+        } else if ((opt == "--user") || (opt == "-u")) {
+            req["User"] = val;
+        } else if (opt == "--name") {
+            name = val;
+        } else if (opt == "--cpuset-cpus") {
+            hostCfg["CpusetCpus"] = val;
+        } else if (opt == "--cpuset-mems") {
+            hostCfg["CpusetMems"] = val;
+        } else if (opt == "--network") {
+            hostCfg["NetworkMode"] = val;
+        } else {
+            logger.error("Unsupported container option %s", opt.c_str());
+            return false;
+        }
+    }
+
+    hostCfg["Binds"] = binds;
+    req["Env"] = env;
+    req["Labels"] = labels;
+    req["HostConfig"] = hostCfg;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: call
+// Performs the request, and checks the status code
+//----------------------------------------------------------------------
+bool DockerApiMng::call(const std::string & method, const std::string & path,
+                        const std::string & body, std::string & resp,
+                        std::initializer_list<int> okCodes)
+{
+    int status = http.request(method, path, body, resp);
+    if (status < 0) {
+        logger.error("Docker API %s %s: %s", method.c_str(), path.c_str(),
+                     http.lastError().c_str());
+        return false;
+    }
+    for (int code: okCodes) {
+        if (status == code) { return true; }
+    }
+    logger.error("Docker API %s %s returned %d: %s", method.c_str(),
+                 path.c_str(), status, resp.c_str());
+    return false;
+}
+
+//----------------------------------------------------------------------
+// Method: parseResponse
+// Parses the JSON body of a response, that may be truncated or not be
+// JSON at all
+//----------------------------------------------------------------------
+bool DockerApiMng::parseResponse(const std::string & path,
+                                 const std::string & resp, json & j)
+{
+    try {
+        j = json::parse(resp);
+    } catch (json::exception & e) {
+        logger.error("Docker API %s: invalid response (%s)", path.c_str(), e.what());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,169 @@
+/******************************************************************************
+ * File:    dckapimng.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.DockerApiMng
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare DockerApiMng class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#ifndef DCKAPIMNG_H
+#define DCKAPIMNG_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   none
+//------------------------------------------------------------
+#include <vector>
+#include <map>
+#include <string>
+#include <sstream>
+
+//------------------------------------------------------------
+// Topic: External packages
+//   none
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//   none
+//------------------------------------------------------------
+#include "dckmng.h"
+#include "uxhttpcli.h"
+#include "log.h"
+
+//==========================================================================
+// Class: DockerApiMng
+// Container manager that talks directly to the Docker Engine REST API
+// through its Unix socket, on a persistent connection, instead of
+// running the docker command line tool
+//==========================================================================
+class DockerApiMng : public DockerMng {
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    DockerApiMng(WorkArea & _wa,
+                 std::string sockPath = std::string("/var/run/docker.sock"));
+
+    //----------------------------------------------------------------------
+    // Method: createContainer
+    // Creates and starts a container that executes the requested
+    // application.  The options are given as for docker run
+    //----------------------------------------------------------------------
+    virtual bool createContainer(std::string img, std::vector<std::string> opts,
+                                 std::map<std::string, std::string> maps,
+                                 std::string exe, std::vector<std::string> args,
+                                 std::string & containerId, std::string & cmd_line);
+
+    //----------------------------------------------------------------------
+    // Method: exec
+    // Runs (detached) the requested application in a running container.
+    // Only the working dir., environment and user options are supported
+    //----------------------------------------------------------------------
+    virtual bool exec(std::string id, std::vector<std::string> opts,
+                      std::string exe, std::vector<std::string> args);
+
+    //----------------------------------------------------------------------
+    // Method: update
+    // Updates the CPU sets of a container
+    //----------------------------------------------------------------------
+    virtual bool update(std::string id, std::vector<std::string> opts);
+
+    //----------------------------------------------------------------------
+    // Method: getInfo
+    // Retrieves the complete inspection information of the container
+    //----------------------------------------------------------------------
+    virtual bool getInfo(std::string id, std::stringstream & info);
+
+    //----------------------------------------------------------------------
+    // Method: inspect
+    // Retrieves the main inspection fields of the container
+    //----------------------------------------------------------------------
+    virtual bool inspect(std::string id, json & summary);
+
+    //----------------------------------------------------------------------
+    // Method: kill
+    // Kill running container
+    //----------------------------------------------------------------------
+    virtual bool kill(std::string id);
+
+    //----------------------------------------------------------------------
+    // Method: remove
+    // Removes exited container
+    //----------------------------------------------------------------------
+    virtual bool remove(std::string id);
+
+    //----------------------------------------------------------------------
+    // Method: getContainerList
+    // Retrieves list of container ids in the form of a vector
+    //----------------------------------------------------------------------
+    virtual bool getContainerList(std::vector<std::string> & contList);
+
+private:
+    //----------------------------------------------------------------------
+    // Method: buildCreateRequest
+    // Translates docker run options into a container creation request
+    //----------------------------------------------------------------------
+    bool buildCreateRequest(std::string & img, std::vector<std::string> & opts,
+                            std::map<std::string, std::string> & maps,
+                            std::string & exe, std::vector<std::string> & args,
+                            json & req, std::string & name);
+
+    //----------------------------------------------------------------------
+    // Method: call
+    // Performs the request, and checks the status code
+    //----------------------------------------------------------------------
+    bool call(const std::string & method, const std::string & path,
+              const std::string & body, std::string & resp,
+              std::initializer_list<int> okCodes);
+
+    //----------------------------------------------------------------------
+    // Method: parseResponse
+    //----------------------------------------------------------------------
+    bool parseResponse(const std::string & path, const std::string & resp,
+                       json & j);
+
+private:
+    UnixHttpClient http;
+
+    Logger logger;
+};
+
+#endif  /* DCKAPIMNG_H */
@@ -0,0 +1,218 @@
+/******************************************************************************
+ * File:    dckevents.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.DockerEventsMonitor
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement DockerEventsMonitor class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#include "dckevents.h"
+
+#include "uxhttpcli.h"
+#include "json.hpp"
+
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+
+using json = nlohmann::json;
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+DockerEventsMonitor::DockerEventsMonitor(std::string _sockPath,
+                                         std::string _label,
+                                         EventHandler _handler)
+    : sockPath(_sockPath), label(_label), handler(_handler),
+      connected(false), quit(false),
+      logger(Log::getLogger("dckevt"))
+{
+}
+
+//----------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------
+DockerEventsMonitor::~DockerEventsMonitor()
+{
+    stop();
+}
+
+//----------------------------------------------------------------------
+// Method: start
+// Launches the listener thread
+//----------------------------------------------------------------------
+void DockerEventsMonitor::start()
+{
+    if (listener.joinable()) { return; }
+    quit = false;
+    listener = std::thread(&DockerEventsMonitor::run, this);
+}
+
+//----------------------------------------------------------------------
+// Method: stop
+// Stops the listener thread (within the stream idle period)
+//----------------------------------------------------------------------
+void DockerEventsMonitor::stop()
+{
+    if (! listener.joinable()) { return; }
+    quit = true;
+    listener.join();
+}
+
+//----------------------------------------------------------------------
+// Method: run
+// Keeps the subscription to the events stream, reconnecting when it
+// is lost
+//----------------------------------------------------------------------
+void DockerEventsMonitor::run()
+{
+    UnixHttpClient http(sockPath);
+    std::string path = eventsPath();
+
+    while (! quit) {
+        lineBuf.clear();
+        int status = http.stream("GET", path,
+                                 [this](const std::string & data) {
+                                     return processData(data); });
+        if (quit) { break; }
+
+        if (connected) {
+            notifyConnection(false);
+        }
+        logger.warn("Docker events stream ended (status %d): %s",
+                    status, http.lastError().c_str());
+
+        for (int i = 0; (i < ReconnectDelay / 100) && (! quit); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+
+    if (connected) { notifyConnection(false); }
+}
+
+//----------------------------------------------------------------------
+// Method: eventsPath
+// Builds the /events request, filtered by type, action and label
+//----------------------------------------------------------------------
+std::string DockerEventsMonitor::eventsPath()
+{
+    json filters = {{"type", {"container"}},
+                    {"event", {"start", "die", "oom"}},
+                    {"label", {label}}};
+    std::string f = filters.dump();
+
+    static const char hex[] = "0123456789ABCDEF";
+    std::string enc;
+    for (unsigned char c : f) {
+        if (isalnum(c) || (c == '-') || (c == '_') || (c == '.') || (c == '~')) {
+            enc += c;
+        } else {
+            enc += '%';
+            enc += hex[c >> 4];
+            enc += hex[c & 0x0f];
+        }
+    }
+    return "/events?filters=" + enc;
+}
+
+//----------------------------------------------------------------------
+// Method: processData
+// Splits the received data into events (one json object per line).
+// The first call means the stream has been established
+//----------------------------------------------------------------------
+bool DockerEventsMonitor::processData(const std::string & data)
+{
+    if (! connected) {
+        notifyConnection(true);
+    }
+
+    lineBuf += data;
+    size_t pos = 0, eol;
+    while ((eol = lineBuf.find('\n', pos)) != std::string::npos) {
+        if (eol > pos) { processEvent(lineBuf.substr(pos, eol - pos)); }
+        pos = eol + 1;
+    }
+    lineBuf.erase(0, pos);
+
+    return ! quit;
+}
+
+//----------------------------------------------------------------------
+// Method: processEvent
+// Parses the event and passes it to the handler
+//----------------------------------------------------------------------
+void DockerEventsMonitor::processEvent(const std::string & line)
+{
+    json jev;
+    try {
+        jev = json::parse(line);
+    } catch (...) {
+        logger.warn("Cannot parse Docker event: %s", line.c_str());
+        return;
+    }
+
+    json & actor = jev["Actor"];
+    json & attrs = actor["Attributes"];
+
+    ContainerEvent ev;
+    ev.contId   = actor.value("ID", "");
+    ev.action   = jev.value("Action", jev.value("status", ""));
+    ev.owner    = attrs.value(label, "");
+    ev.exitCode = -1;
+    if (attrs.count("exitCode") > 0) {
+        ev.exitCode = std::atoi(attrs["exitCode"].get<std::string>().c_str());
+    }
+
+    if (ev.contId.empty() || ev.owner.empty()) { return; }
+    logger.debug("Container %s (%s): %s", ev.contId.c_str(),
+                 ev.owner.c_str(), ev.action.c_str());
+    handler(ev);
+}
+
+//----------------------------------------------------------------------
+// Method: notifyConnection
+// Sends the connected/disconnected event to the handler
+//----------------------------------------------------------------------
+void DockerEventsMonitor::notifyConnection(bool isUp)
+{
+    connected = isUp;
+    logger.info("Docker events stream %s",
+                isUp ? "established" : "lost");
+    ContainerEvent ev {"", isUp ? "connected" : "disconnected", "", -1};
+    handler(ev);
+}
+
+const int DockerEventsMonitor::ReconnectDelay = 2000;
@@ -0,0 +1,153 @@
+/******************************************************************************
+ * File:    dckevents.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.DockerEventsMonitor
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare DockerEventsMonitor class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#ifndef DOCKEREVENTSMONITOR_H
+#define DOCKEREVENTSMONITOR_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//   - thread
+//   - atomic
+//   - functional
+//------------------------------------------------------------
+#include <string>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+#include "agentmsg.h"
+#include "log.h"
+
+//==========================================================================
+// Class: DockerEventsMonitor
+// Subscribes to the Docker Engine /events stream, for the containers
+// carrying the given label, and passes their start, die and oom events
+// to the handler, in its own thread.  The handler also receives a
+// "connected" event each time the subscription is (re)established,
+// and a "disconnected" event when it is lost, so that the consumers
+// can reconcile the state of their containers, or fall back to polling
+//==========================================================================
+class DockerEventsMonitor {
+
+public:
+    typedef std::function<void(ContainerEvent & ev)> EventHandler;
+
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    DockerEventsMonitor(std::string _sockPath, std::string _label,
+                        EventHandler _handler);
+
+    //----------------------------------------------------------------------
+    // Destructor
+    //----------------------------------------------------------------------
+    virtual ~DockerEventsMonitor();
+
+    //----------------------------------------------------------------------
+    // Method: start
+    //----------------------------------------------------------------------
+    void start();
+
+    //----------------------------------------------------------------------
+    // Method: stop
+    //----------------------------------------------------------------------
+    void stop();
+
+    //----------------------------------------------------------------------
+    // Method: isConnected
+    //----------------------------------------------------------------------
+    bool isConnected() const { return connected; }
+
+private:
+    //----------------------------------------------------------------------
+    // Method: run
+    //----------------------------------------------------------------------
+    void run();
+
+    //----------------------------------------------------------------------
+    // Method: eventsPath
+    //----------------------------------------------------------------------
+    std::string eventsPath();
+
+    //----------------------------------------------------------------------
+    // Method: processData
+    //----------------------------------------------------------------------
+    bool processData(const std::string & data);
+
+    //----------------------------------------------------------------------
+    // Method: processEvent
+    //----------------------------------------------------------------------
+    void processEvent(const std::string & line);
+
+    //----------------------------------------------------------------------
+    // Method: notifyConnection
+    //----------------------------------------------------------------------
+    void notifyConnection(bool isUp);
+
+private:
+    std::string sockPath;
+    std::string label;
+    EventHandler handler;
+
+    std::string lineBuf;
+
+    std::atomic<bool> connected;
+    std::atomic<bool> quit;
+    std::thread listener;
+
+    Logger logger;
+
+    static const int ReconnectDelay;
+};
+
+#endif // DOCKEREVENTSMONITOR_H
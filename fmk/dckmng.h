@@ -65,6 +65,9 @@
 //------------------------------------------------------------
 #include "wa.h"
 
+#include "json.hpp"
+using json = nlohmann::json;
+
 //==========================================================================
 // Class: DockerMng
 //==========================================================================
@@ -97,6 +100,17 @@ public:
                                  std::string exe, std::vector<std::string> args,
                                  std::string & containerId) {}
 
+    //----------------------------------------------------------------------
+    // Method: createContainer
+    // Creates a container that executes the requested application, and
+    // returns a description of the command used
+    //----------------------------------------------------------------------
+    virtual bool createContainer(std::string img, std::vector<std::string> opts,
+                                 std::map<std::string, std::string> maps,
+                                 std::string exe, std::vector<std::string> args,
+                                 std::string & containerId,
+                                 std::string & cmd_line) { return false; }
+
     //----------------------------------------------------------------------
     // Method: createContainer
     // Creates a container that executes the requested application
@@ -104,6 +118,20 @@ public:
     virtual bool createContainer(std::string proc, std::string workDir,
                                  std::string & containerId) {}
 
+    //----------------------------------------------------------------------
+    // Method: exec
+    // Runs (detached) the requested application in a running container.
+    // The options are given as for docker exec
+    //----------------------------------------------------------------------
+    virtual bool exec(std::string id, std::vector<std::string> opts,
+                      std::string exe, std::vector<std::string> args) { return false; }
+
+    //----------------------------------------------------------------------
+    // Method: update
+    // Updates the resources of a container (i.e.: --cpuset-cpus)
+    //----------------------------------------------------------------------
+    virtual bool update(std::string id, std::vector<std::string> opts) { return false; }
+
     //----------------------------------------------------------------------
     // Method: reScaleService
     // Rescales a running service
@@ -128,6 +156,13 @@ public:
     //----------------------------------------------------------------------
     virtual bool getInfo(std::string id, std::string & info);
 
+    //----------------------------------------------------------------------
+    // Method: inspect
+    // Retrieves the main inspection fields (Id, State, Path, Args and
+    // Config) of the container
+    //----------------------------------------------------------------------
+    virtual bool inspect(std::string id, json & summary) { return false; }
+
     //----------------------------------------------------------------------
     // Method: kill
     // Kill running container
@@ -140,6 +175,16 @@ public:
     //----------------------------------------------------------------------
     virtual bool remove(std::string id) {}
 
+    //----------------------------------------------------------------------
+    // Method: removeBatch
+    // Removes a set of exited containers
+    //----------------------------------------------------------------------
+    virtual bool removeBatch(std::vector<std::string> & ids) {
+        bool ok = true;
+        for (auto & id: ids) { ok = remove(id) && ok; }
+        return ok;
+    }
+
     //----------------------------------------------------------------------
     // Method: leaveSwarm
     // Make a node leave the swarm
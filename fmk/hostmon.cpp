@@ -0,0 +1,235 @@
+/******************************************************************************
+ * File:    hostmon.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.HostMonitor
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement HostMonitor class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#include "hostmon.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/statvfs.h>
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+HostMonitor::HostMonitor(std::string _diskPath, int _periodMs)
+    : diskPath(_diskPath), periodMs(_periodMs),
+      lastCpuBusy(0), lastCpuTotal(0), seq(0), quit(false)
+{
+    std::memset(&current, 0, sizeof(current));
+
+    // Static facts are read only once
+    char buf[1024];
+    int fd = open("/proc/version", O_RDONLY | O_CLOEXEC);
+    int n = (fd < 0) ? 0 : readProcFile(fd, buf, sizeof(buf));
+    if (fd >= 0) { close(fd); }
+    while ((n > 0) && (buf[n - 1] == '\n')) { --n; }
+    unameStr = std::string(buf, n);
+
+    ncpus = (int)(sysconf(_SC_NPROCESSORS_ONLN));
+    if (ncpus < 1) { ncpus = 1; }
+
+    // Files sampled periodically are kept open
+    fdLoadAvg = open("/proc/loadavg", O_RDONLY | O_CLOEXEC);
+    fdStat    = open("/proc/stat", O_RDONLY | O_CLOEXEC);
+    fdMemInfo = open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+    fdDisk    = open(diskPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    // First sample (CPU usage will be available from the second one)
+    HostTelemetry t;
+    sample(t);
+    publish(t);
+}
+
+//----------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------
+HostMonitor::~HostMonitor()
+{
+    stop();
+    for (int fd : {fdLoadAvg, fdStat, fdMemInfo, fdDisk}) {
+        if (fd >= 0) { close(fd); }
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: start
+// Launches the sampler thread
+//----------------------------------------------------------------------
+void HostMonitor::start()
+{
+    if (sampler.joinable()) { return; }
+    quit = false;
+    sampler = std::thread(&HostMonitor::run, this);
+}
+
+//----------------------------------------------------------------------
+// Method: stop
+// Stops the sampler thread
+//----------------------------------------------------------------------
+void HostMonitor::stop()
+{
+    if (! sampler.joinable()) { return; }
+    {
+        std::lock_guard<std::mutex> lock(quitMtx);
+        quit = true;
+    }
+    quitCv.notify_all();
+    sampler.join();
+}
+
+//----------------------------------------------------------------------
+// Method: get
+// Returns a consistent copy of the last sample taken
+//----------------------------------------------------------------------
+HostTelemetry HostMonitor::get() const
+{
+    HostTelemetry t;
+    unsigned s1, s2;
+    do {
+        s1 = seq.load(std::memory_order_acquire);
+        std::memcpy(&t, &current, sizeof(t));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        s2 = seq.load(std::memory_order_relaxed);
+    } while ((s1 & 1) || (s1 != s2));
+    return t;
+}
+
+//----------------------------------------------------------------------
+// Method: run
+// Sampler thread main loop
+//----------------------------------------------------------------------
+void HostMonitor::run()
+{
+    HostTelemetry t;
+    std::unique_lock<std::mutex> lock(quitMtx);
+    while (! quit) {
+        quitCv.wait_for(lock, std::chrono::milliseconds(periodMs));
+        if (quit) { break; }
+        sample(t);
+        publish(t);
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: publish
+// Stores the new sample (sequence lock, single writer)
+//----------------------------------------------------------------------
+void HostMonitor::publish(const HostTelemetry & t)
+{
+    unsigned s = seq.load(std::memory_order_relaxed);
+    seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&current, &t, sizeof(t));
+    seq.store(s + 2, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------
+// Method: readProcFile
+// Reads the file from the beginning, as a null terminated string
+//----------------------------------------------------------------------
+int HostMonitor::readProcFile(int fd, char * buf, int sz)
+{
+    ssize_t n = (fd < 0) ? -1 : pread(fd, buf, sz - 1, 0);
+    if (n < 0) { n = 0; }
+    buf[n] = '\0';
+    return (int)(n);
+}
+
+//----------------------------------------------------------------------
+// Method: sample
+// Takes a new sample of the host resources
+//----------------------------------------------------------------------
+void HostMonitor::sample(HostTelemetry & t)
+{
+    char buf[4096];
+
+    std::memset(&t, 0, sizeof(t));
+    t.timeStamp = std::chrono::duration_cast<std::chrono::seconds>
+        (std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // Load averages
+    if (readProcFile(fdLoadAvg, buf, sizeof(buf)) > 0) {
+        char * p = buf;
+        for (int i = 0; i < 3; ++i) { t.load[i] = std::strtod(p, &p); }
+    }
+
+    // CPU usage, from the aggregated line of /proc/stat:
+    // cpu user nice system idle iowait irq softirq steal ...
+    if ((readProcFile(fdStat, buf, sizeof(buf)) > 0) &&
+        (std::strncmp(buf, "cpu ", 4) == 0)) {
+        char * p = buf + 4;
+        unsigned long long v, total = 0, idle = 0;
+        for (int i = 0; i < 8; ++i) {
+            v = std::strtoull(p, &p, 10);
+            total += v;
+            if ((i == 3) || (i == 4)) { idle += v; }
+        }
+        unsigned long long busy = total - idle;
+        if ((lastCpuTotal > 0) && (total > lastCpuTotal)) {
+            t.cpuPct = (100.0 * (double)(busy - lastCpuBusy) /
+                        (double)(total - lastCpuTotal));
+        } else {
+            t.cpuPct = current.cpuPct;
+        }
+        lastCpuBusy = busy;
+        lastCpuTotal = total;
+    }
+
+    // Memory (in bytes)
+    if (readProcFile(fdMemInfo, buf, sizeof(buf)) > 0) {
+        char * p;
+        if ((p = std::strstr(buf, "MemTotal:")) != nullptr) {
+            t.memTotal = std::strtoull(p + 9, nullptr, 10) * 1024;
+        }
+        if ((p = std::strstr(buf, "MemAvailable:")) != nullptr) {
+            t.memAvailable = std::strtoull(p + 13, nullptr, 10) * 1024;
+        }
+    }
+
+    // Work area disk (in bytes)
+    struct statvfs vfs;
+    if ((fdDisk >= 0) && (fstatvfs(fdDisk, &vfs) == 0)) {
+        t.diskTotal = (unsigned long long)(vfs.f_blocks) * vfs.f_frsize;
+        t.diskFree = (unsigned long long)(vfs.f_bavail) * vfs.f_frsize;
+    }
+}
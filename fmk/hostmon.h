@@ -0,0 +1,176 @@
+/******************************************************************************
+ * File:    hostmon.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.HostMonitor
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare HostMonitor class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#ifndef HOSTMONITOR_H
+#define HOSTMONITOR_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//   - thread
+//   - atomic
+//   - mutex
+//   - condition_variable
+//------------------------------------------------------------
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+
+//==========================================================================
+// Struct: HostTelemetry
+// Last sample of the host resources
+//==========================================================================
+struct HostTelemetry {
+    double             load[3];
+    double             cpuPct;
+    unsigned long long memTotal;
+    unsigned long long memAvailable;
+    unsigned long long diskTotal;
+    unsigned long long diskFree;
+    long long          timeStamp;
+};
+
+//==========================================================================
+// Class: HostMonitor
+// Samples the host resources periodically in its own thread.  The /proc
+// files and the work area folder are kept open, and read again with
+// pread/fstatvfs at each sample.  The last sample is published with a
+// sequence lock, so readers never block the sampler (nor the other way
+// round).
+//==========================================================================
+class HostMonitor {
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    HostMonitor(std::string _diskPath, int _periodMs = 1000);
+
+    //----------------------------------------------------------------------
+    // Destructor
+    //----------------------------------------------------------------------
+    virtual ~HostMonitor();
+
+    //----------------------------------------------------------------------
+    // Method: start
+    //----------------------------------------------------------------------
+    void start();
+
+    //----------------------------------------------------------------------
+    // Method: stop
+    //----------------------------------------------------------------------
+    void stop();
+
+    //----------------------------------------------------------------------
+    // Method: get
+    // Returns the last sample taken
+    //----------------------------------------------------------------------
+    HostTelemetry get() const;
+
+    //----------------------------------------------------------------------
+    // Method: uname
+    //----------------------------------------------------------------------
+    const std::string & uname() const { return unameStr; }
+
+    //----------------------------------------------------------------------
+    // Method: numOfCpus
+    //----------------------------------------------------------------------
+    int numOfCpus() const { return ncpus; }
+
+private:
+    //----------------------------------------------------------------------
+    // Method: run
+    //----------------------------------------------------------------------
+    void run();
+
+    //----------------------------------------------------------------------
+    // Method: sample
+    //----------------------------------------------------------------------
+    void sample(HostTelemetry & t);
+
+    //----------------------------------------------------------------------
+    // Method: readProcFile
+    //----------------------------------------------------------------------
+    int readProcFile(int fd, char * buf, int sz);
+
+    //----------------------------------------------------------------------
+    // Method: publish
+    //----------------------------------------------------------------------
+    void publish(const HostTelemetry & t);
+
+private:
+    std::string diskPath;
+    int periodMs;
+
+    std::string unameStr;
+    int ncpus;
+
+    int fdLoadAvg;
+    int fdStat;
+    int fdMemInfo;
+    int fdDisk;
+
+    unsigned long long lastCpuBusy;
+    unsigned long long lastCpuTotal;
+
+    HostTelemetry current;
+    std::atomic<unsigned> seq;
+
+    std::atomic<bool> quit;
+    std::mutex quitMtx;
+    std::condition_variable quitCv;
+    std::thread sampler;
+};
+
+#endif // HOSTMONITOR_H
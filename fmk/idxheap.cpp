@@ -0,0 +1,123 @@
+/******************************************************************************
+ * File:    idxheap.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.IndexedMinHeap
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement IndexedMinHeap class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#include "idxheap.h"
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+IndexedMinHeap::IndexedMinHeap(int n)
+{
+    resize(n);
+}
+
+//----------------------------------------------------------------------
+// Method: resize
+// Resets the heap to n elements, all of them with (0, 0) keys
+//----------------------------------------------------------------------
+void IndexedMinHeap::resize(int n)
+{
+    heap.resize(n);
+    pos.resize(n);
+    keys.assign(n, 0);
+    ties.assign(n, 0);
+    for (int i = 0; i < n; ++i) { heap[i] = i, pos[i] = i; }
+}
+
+//----------------------------------------------------------------------
+// Method: update
+// Sets the key of an element, and restores the heap property
+//----------------------------------------------------------------------
+void IndexedMinHeap::update(int i, int key, int tie)
+{
+    keys.at(i) = key;
+    ties.at(i) = tie;
+    siftUp(pos[i]);
+    siftDown(pos[i]);
+}
+
+//----------------------------------------------------------------------
+// Method: less
+//----------------------------------------------------------------------
+bool IndexedMinHeap::less(int a, int b) const
+{
+    if (keys[a] != keys[b]) { return keys[a] < keys[b]; }
+    if (ties[a] != ties[b]) { return ties[a] < ties[b]; }
+    return a < b;
+}
+
+//----------------------------------------------------------------------
+// Method: swap
+//----------------------------------------------------------------------
+void IndexedMinHeap::swap(int k, int l)
+{
+    int a = heap[k], b = heap[l];
+    heap[k] = b, pos[b] = k;
+    heap[l] = a, pos[a] = l;
+}
+
+//----------------------------------------------------------------------
+// Method: siftUp
+//----------------------------------------------------------------------
+void IndexedMinHeap::siftUp(int k)
+{
+    while (k > 0) {
+        int parent = (k - 1) / 2;
+        if (! less(heap[k], heap[parent])) { break; }
+        swap(k, parent);
+        k = parent;
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: siftDown
+//----------------------------------------------------------------------
+void IndexedMinHeap::siftDown(int k)
+{
+    int n = heap.size();
+    for (;;) {
+        int l = 2 * k + 1, r = l + 1, m = k;
+        if ((l < n) && less(heap[l], heap[m])) { m = l; }
+        if ((r < n) && less(heap[r], heap[m])) { m = r; }
+        if (m == k) { break; }
+        swap(k, m);
+        k = m;
+    }
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+ * File:    idxheap.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.IndexedMinHeap
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare IndexedMinHeap class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#ifndef INDEXEDMINHEAP_H
+#define INDEXEDMINHEAP_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - vector
+//------------------------------------------------------------
+#include <vector>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+
+//==========================================================================
+// Class: IndexedMinHeap
+// Binary min-heap of the elements 0..n-1, ordered by a (key, tie)
+// pair of integers.  The position of each element in the heap is kept,
+// so that the key of any element can be changed in O(log n).  Equal
+// pairs are ordered by element index.
+//==========================================================================
+class IndexedMinHeap {
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    IndexedMinHeap(int n = 0);
+
+    //----------------------------------------------------------------------
+    // Method: resize
+    // Resets the heap to n elements, all of them with (0, 0) keys
+    //----------------------------------------------------------------------
+    void resize(int n);
+
+    //----------------------------------------------------------------------
+    // Method: size
+    //----------------------------------------------------------------------
+    int size() const { return (int)(heap.size()); }
+
+    //----------------------------------------------------------------------
+    // Method: top
+    // Returns the element with the minimum key
+    //----------------------------------------------------------------------
+    int top() const { return heap.front(); }
+
+    //----------------------------------------------------------------------
+    // Method: update
+    // Sets the key of an element, and restores the heap property
+    //----------------------------------------------------------------------
+    void update(int i, int key, int tie);
+
+    //----------------------------------------------------------------------
+    // Method: key
+    //----------------------------------------------------------------------
+    int key(int i) const { return keys.at(i); }
+
+private:
+    //----------------------------------------------------------------------
+    // Method: less
+    //----------------------------------------------------------------------
+    bool less(int a, int b) const;
+
+    //----------------------------------------------------------------------
+    // Method: swap
+    //----------------------------------------------------------------------
+    void swap(int k, int l);
+
+    //----------------------------------------------------------------------
+    // Method: siftUp
+    //----------------------------------------------------------------------
+    void siftUp(int k);
+
+    //----------------------------------------------------------------------
+    // Method: siftDown
+    //----------------------------------------------------------------------
+    void siftDown(int k);
+
+private:
+    std::vector<int> heap;
+    std::vector<int> pos;
+    std::vector<int> keys;
+    std::vector<int> ties;
+};
+
+#endif // INDEXEDMINHEAP_H
@@ -0,0 +1,182 @@
+/******************************************************************************
+ * File:    jointbl.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.JoinTable
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement JoinTable class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#include "jointbl.h"
+
+#include <unistd.h>
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+JoinTable::JoinTable(string _journal)
+    : journalFile(_journal),
+      logger(Log::getLogger("jointbl"))
+{
+    restore();
+}
+
+//----------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------
+JoinTable::~JoinTable()
+{
+    jnl.close();
+}
+
+//----------------------------------------------------------------------
+// Method: groupId
+//----------------------------------------------------------------------
+string JoinTable::groupId(string const & rule, string const & key)
+{
+    return rule + "|" + key;
+}
+
+//----------------------------------------------------------------------
+// Method: restore
+// Replays the journal, and writes it back with only the live groups
+//----------------------------------------------------------------------
+void JoinTable::restore()
+{
+    std::ifstream ifs(journalFile);
+    string line;
+    int numRecs = 0;
+    while (std::getline(ifs, line)) {
+        if (line.empty()) { continue; }
+        json rec;
+        try {
+            rec = json::parse(line);
+        } catch(...) {
+            // Last record may be truncated if we died while writing it
+            logger.warn("Skipping invalid join journal record");
+            continue;
+        }
+        ++numRecs;
+        string op = rec["op"];
+        string rule = rec["rule"];
+        string key = rec["key"];
+        string gid = groupId(rule, key);
+        if (op == "add") {
+            auto it = table.find(gid);
+            if (it == table.end()) {
+                table[gid] = Group({rule, key, rec["t"].get<time_t>(), {}});
+                it = table.find(gid);
+            }
+            it->second.prods.push_back(rec["meta"]);
+        } else if (op == "del") {
+            table.erase(gid);
+        }
+    }
+    ifs.close();
+
+    // Compact journal: rewrite it only with the live groups
+    string tmpFile = journalFile + ".tmp";
+    jnl.open(tmpFile, std::ofstream::out | std::ofstream::trunc);
+    for (auto & kv: table) {
+        Group & g = kv.second;
+        for (auto & m: g.prods) {
+            journal(json({{"op", "add"}, {"rule", g.rule}, {"key", g.key},
+                          {"t", g.firstSeen}, {"meta", m}}));
+        }
+    }
+    jnl.close();
+    if (rename(tmpFile.c_str(), journalFile.c_str()) != 0) {
+        logger.error("Cannot compact join journal %s: %s",
+                     journalFile.c_str(), strerror(errno));
+    }
+    jnl.open(journalFile, std::ofstream::out | std::ofstream::app);
+
+    if (numRecs > 0) {
+        logger.info("Join table restored with %d pending groups",
+                    (int)(table.size()));
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: journal
+//----------------------------------------------------------------------
+void JoinTable::journal(json const & rec)
+{
+    jnl << rec.dump() << '\n';
+    jnl.flush();
+}
+
+//----------------------------------------------------------------------
+// Method: add
+// Adds a product to a group, creating it if needed
+//----------------------------------------------------------------------
+bool JoinTable::add(string const & rule, string const & key, ProductMeta & meta)
+{
+    string gid = groupId(rule, key);
+    auto it = table.find(gid);
+    if (it == table.end()) {
+        table[gid] = Group({rule, key, time(nullptr), {}});
+        it = table.find(gid);
+    }
+
+    Group & g = it->second;
+    string const & base = meta["fileinfo"]["base"].get_ref<string const &>();
+    for (auto & m: g.prods) {
+        if (m["fileinfo"]["base"] == base) { return false; }
+    }
+
+    g.prods.push_back(meta);
+    journal(json({{"op", "add"}, {"rule", rule}, {"key", key},
+                  {"t", g.firstSeen}, {"meta", meta}}));
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: find
+//----------------------------------------------------------------------
+JoinTable::Group * JoinTable::find(string const & rule, string const & key)
+{
+    auto it = table.find(groupId(rule, key));
+    return (it == table.end()) ? nullptr : &(it->second);
+}
+
+//----------------------------------------------------------------------
+// Method: remove
+// Removes a group, once the rule has fired
+//----------------------------------------------------------------------
+void JoinTable::remove(string const & rule, string const & key)
+{
+    table.erase(groupId(rule, key));
+    journal(json({{"op", "del"}, {"rule", rule}, {"key", key}}));
+}
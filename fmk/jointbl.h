@@ -0,0 +1,142 @@
+/******************************************************************************
+ * File:    jointbl.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.JoinTable
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare JoinTable class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#ifndef JOINTABLE_H
+#define JOINTABLE_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - iostream
+//------------------------------------------------------------
+#include <iostream>
+#include <fstream>
+#include <ctime>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+#include "types.h"
+#include "log.h"
+
+//==========================================================================
+// Class: JoinTable
+// In-memory table of the product groups being accumulated by the join,
+// count and window rules, keyed by rule name and group key (obs_id,
+// signature...).  Every change is appended to a journal file, which is
+// replayed (and compacted) at start up, so that pending groups survive
+// a restart.
+//==========================================================================
+class JoinTable {
+
+public:
+    struct Group {
+        string rule;
+        string key;
+        time_t firstSeen;
+        ProductMetaList prods;
+    };
+
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    JoinTable(string _journal);
+
+    //----------------------------------------------------------------------
+    // Destructor
+    //----------------------------------------------------------------------
+    virtual ~JoinTable();
+
+    //----------------------------------------------------------------------
+    // Method: add
+    // Adds a product to a group, creating it if needed.  Returns false
+    // if the product was already in the group
+    //----------------------------------------------------------------------
+    bool add(string const & rule, string const & key, ProductMeta & meta);
+
+    //----------------------------------------------------------------------
+    // Method: find
+    //----------------------------------------------------------------------
+    Group * find(string const & rule, string const & key);
+
+    //----------------------------------------------------------------------
+    // Method: remove
+    // Removes a group, once the rule has fired
+    //----------------------------------------------------------------------
+    void remove(string const & rule, string const & key);
+
+    //----------------------------------------------------------------------
+    // Method: groups
+    //----------------------------------------------------------------------
+    map<string, Group> & groups() { return table; }
+
+    //----------------------------------------------------------------------
+    // Method: groupId
+    //----------------------------------------------------------------------
+    static string groupId(string const & rule, string const & key);
+
+private:
+    //----------------------------------------------------------------------
+    // Method: restore
+    // Replays the journal, and writes it back with only the live groups
+    //----------------------------------------------------------------------
+    void restore();
+
+    //----------------------------------------------------------------------
+    // Method: journal
+    //----------------------------------------------------------------------
+    void journal(json const & rec);
+
+private:
+    string journalFile;
+    std::ofstream jnl;
+    map<string, Group> table;
+
+    Logger logger;
+};
+
+#endif // JOINTABLE_H
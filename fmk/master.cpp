@@ -89,6 +89,9 @@ Master::Master(string _cfg, string _id, int _port, string _wa, int _bMode)
     tskOrc = new TaskOrchestrator(cfg, id);
     tskMng = new TaskManager(cfg, id, wa, *net);
 
+    // Create the relocator of output products
+    createRelocator();
+
     // Create Data Manager
     if (net->thisIsCommander) {
         dataMng = new DataManager(cfg, *net);
@@ -273,15 +276,12 @@ bool Master::getNewEntriesFromDirWatcher(DirWatcher * dw, Queue<string> & q)
 
 //----------------------------------------------------------------------
 // Method: getHostInfo
-//
+// Returns the last snapshot of the node information published by the
+// main loop.  Safe to be called from other threads
 //----------------------------------------------------------------------
-string Master::getHostInfo()
+SnapshotPtr Master::getHostInfo()
 {
-    if (nodeInfoIsAvailable) {
-        return nodeInfo.dump(); //nodeInfo.dump();
-    } else {
-        return "{}";
-    }
+    return nodeInfoSnapshot.get();
 }
 
 //----------------------------------------------------------------------
@@ -304,8 +304,13 @@ void Master::distributeProducts()
     for (int i = 0; i < nodeStatus.size(); ++i) {
         if (nodeStatusIsAvailable[i]) {
             try {
-                json jloads = nodeStatus[i]["machine"]["load"];
-                loads[i] = jloads[0].get<double>();
+                // Use CPU usage when available, as the load average lags
+                json & jmachine = nodeStatus[i]["machine"];
+                if (jmachine.count("cpu") > 0) {
+                    loads[i] = jmachine["cpu"].get<double>() / 100.;
+                } else {
+                    loads[i] = jmachine["load"][0].get<double>();
+                }
             } catch (...) {
                 loads[i] = 1.0;
             }
@@ -403,24 +408,9 @@ void Master::scheduleProductsForProcessing()
             logger.warn("File '" + prod + "' doesn't seem to be a valid product");
             continue;
         }
-
-        logger.info("Product '" + prod + "' will be processed");
-
-        logger.debug(fmt("$:$: Try to archive product $",
-                         __FUNCTION__, __LINE__, prod));
-
-        if (!ProductLocator::toLocalArchive(meta, wa)) {
-            logger.error("Move (link) to archive of %s failed", prod.c_str());
-            continue;
-        }
-       
-        if (! tskOrc->schedule(meta, *tskMng)) {
-            logger.error("Couldn't schedule the processing of %s", prod.c_str());
-            (void)unlink(prod.c_str());
-            continue;
+        if (scheduleProduct(prod, meta)) {
+            products.push_back(meta);
         }
-
-        products.push_back(meta);
     }
 
     // The inputs products dispatched to other nodes only have to be
@@ -434,37 +424,155 @@ void Master::scheduleProductsForProcessing()
             products.push_back(meta);
         }
         
-        dataMng->storeProducts(products);
+        storeScheduledProducts(products);
+    }
+}
 
-        for (auto & m: products) {
-            string prod = m["fileinfo"]["full"].get<string>();
-            logger.debug("Removing archived product %s", prod.c_str());
-            (void)unlink(prod.c_str());
+//----------------------------------------------------------------------
+// Method: scheduleHandedOutputs
+// Schedule the outputs handed over directly by the agents of this
+// node.  They are already parsed, and are processed in this node.
+// Those that need a version tag are moved to the inbox, to take the
+// usual path
+//----------------------------------------------------------------------
+void Master::scheduleHandedOutputs()
+{
+    vector<HandedOutput> outputs;
+    if (! tskMng->retrieveHandedOutputs(outputs)) { return; }
+
+    ProductMetaList products;
+    for (auto & o: outputs) {
+        string prod = o.meta["fileinfo"]["full"].get<string>();
+        if (o.needsVersion && net->thisIsCommander) {
+            if (! ProductLocator::toLocalInbox(o.meta, wa)) {
+                logger.error("Cannot move %s to local inbox folder", prod.c_str());
+            }
+            continue;
+        }
+        if (scheduleProduct(prod, o.meta)) {
+            products.push_back(o.meta);
         }
     }
+
+    if (net->thisIsCommander) {
+        storeScheduledProducts(products);
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: scheduleProduct
+// Archive the product, and schedule its processing
+//----------------------------------------------------------------------
+bool Master::scheduleProduct(string & prod, ProductMeta & meta)
+{
+    logger.info("Product '" + prod + "' will be processed");
+
+    logger.debug(fmt("$:$: Try to archive product $",
+                     __FUNCTION__, __LINE__, prod));
+
+    if (!ProductLocator::toLocalArchive(meta, wa)) {
+        logger.error("Move (link) to archive of %s failed", prod.c_str());
+        return false;
+    }
+       
+    if (! tskOrc->schedule(meta, *tskMng)) {
+        logger.error("Couldn't schedule the processing of %s", prod.c_str());
+        (void)unlink(prod.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: storeScheduledProducts
+// Store the scheduled products in the DB (commander only)
+//----------------------------------------------------------------------
+void Master::storeScheduledProducts(ProductMetaList & products)
+{
+    if (products.empty()) { return; }
+
+    dataMng->storeProducts(products);
+
+    for (auto & m: products) {
+        string prod = m["fileinfo"]["full"].get<string>();
+        logger.debug("Removing archived product %s", prod.c_str());
+        (void)unlink(prod.c_str());
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: createRelocator
+// Create the relocator of products, with the number of workers, the
+// dead-letter folder and the retry policies for specific errors in the
+// relocation section of the general settings
+//----------------------------------------------------------------------
+void Master::createRelocator()
+{
+    json rel = cfg["general"].value("relocation", json::object());
+    string deadLetter = rel.value("deadLetter", wa.wa + "/data/dead-letter");
+    relocator = new Relocator(deadLetter, rel.value("workers", 2));
+
+    if (rel.count("retries") > 0) {
+        for (auto & kv: rel["retries"].items()) {
+            int err = Relocator::errorCode(kv.key());
+            if (err == 0) {
+                logger.warn("Unknown error %s in relocation retries",
+                            kv.key().c_str());
+                continue;
+            }
+            json & pol = kv.value();
+            relocator->setRetryPolicy(err, pol.value("maxRetries", 0),
+                                      pol.value("delay", 0));
+        }
+    }
+
+    if (! relocator->start()) {
+        logger.fatal("Cannot start the relocator of products. Exiting.");
+    }
 }
 
 //----------------------------------------------------------------------
 // Method: archiveOutputs
-// Save output products to the local archive
+// Save output products to the local archive.  They are moved by the
+// relocator, and stored in the DB once there
 //----------------------------------------------------------------------
 void Master::archiveOutputs()
 {
     ProductName prod;
     ProductMeta meta;
-    ProductMetaList products;
     bool needsVersion;
     while (outputProducts.get(prod)) {
-        if (checkIfProduct(prod, meta, needsVersion)) {
-            products.push_back(meta);
-            logger.debug("Moving output product " + prod + " to archive");
-
-            logger.debug(fmt("$:$: Try to archive product $",
-                             __FUNCTION__, __LINE__, prod));
-            ProductLocator::toLocalArchive(meta, wa, ProductLocator::MOVE);
-        } else {
+        if (! checkIfProduct(prod, meta, needsVersion)) {
             logger.warn("Found non-product file in local outputs folder: " + prod);
+            continue;
         }
+        logger.debug("Moving output product " + prod + " to archive");
+
+        string newFile = wa.archive + "/" + meta["fileinfo"]["base"].get<string>();
+        relocator->submit(prod, newFile, ProductLocator::MOVE,
+                          [this, meta, newFile](int err) mutable {
+                              if (err != 0) { return; }
+                              meta["fileinfo"]["full"] = newFile;
+                              meta["fileinfo"]["path"] = wa.archive;
+                              std::lock_guard<std::mutex> lock(archivedMtx);
+                              archivedProducts.push_back(meta);
+                          });
+    }
+
+    storeArchivedOutputs();
+}
+
+//----------------------------------------------------------------------
+// Method: storeArchivedOutputs
+// Store in the DB the output products already in the archive
+//----------------------------------------------------------------------
+void Master::storeArchivedOutputs()
+{
+    ProductMetaList products;
+    {
+        std::lock_guard<std::mutex> lock(archivedMtx);
+        products.swap(archivedProducts);
     }
     if (products.size() > 0) {
         dataMng->storeProducts(products);
@@ -629,11 +737,18 @@ void Master::runMainLoop()
         if (!productList.empty()) {
             scheduleProductsForProcessing();
         }
+        scheduleHandedOutputs();
+
+        // Fire group rules with expired time windows
+        tskOrc->checkPendingGroups(*tskMng);
 
         // Retrieve agents information
         if ((iteration == 1) || ((iteration % 5) == 0)) {
             nodeInfoIsAvailable = tskMng->retrieveAgentsInfo(nodeInfo);
             //logger.debug("Node info retrieved: " + nodeInfo.dump());
+            if (nodeInfoIsAvailable) {
+                nodeInfoSnapshot.publish(nodeInfo.dump());
+            }
             tskMng->showSpectra();
         }
 
@@ -670,12 +785,15 @@ void Master::runMainLoop()
             gatherTasksStatus();            
         }
 
-        // Wait a little bit until next loop
+        // Wait a little bit until next loop, scheduling meanwhile the
+        // outputs handed over by the agents as soon as they arrive
         while (next_time < std::chrono::steady_clock::now()) {
             next_time += std::chrono::seconds(1);
             ++iteration;
         }
-        std::this_thread::sleep_until(next_time);
+        while (tskMng->waitForHandedOutputs(next_time)) {
+            scheduleHandedOutputs();
+        }
 
     }
 }
@@ -700,7 +818,12 @@ void Master::terminate()
     delete httpServer;
     delete tskMng;
     delete tskOrc;
-    if (net->thisIsCommander) delete dataMng;
+    relocator->stop();
+    if (net->thisIsCommander) {
+        storeArchivedOutputs();
+        delete dataMng;
+    }
+    delete relocator;
 
     logger.info("Done.");
 }
@@ -52,6 +52,7 @@
 #include <iostream>
 
 #include <random>
+#include <mutex>
 #include "limits.h"
 
 //------------------------------------------------------------
@@ -64,9 +65,11 @@
 #include "types.h"
 #include "wa.h"
 #include "procnet.h"
+#include "snapshot.h"
 #include "taskorc.h"
 #include "taskmng.h"
 #include "datamng.h"
+#include "relocator.h"
 #include "q.h"
 
 #include "log.h"
@@ -98,7 +101,7 @@ public:
     //----------------------------------------------------------------------
     // Method: getHostInfo
     //----------------------------------------------------------------------
-    string getHostInfo();
+    SnapshotPtr getHostInfo();
 
 protected:
 
@@ -159,11 +162,36 @@ private:
     //----------------------------------------------------------------------
     void scheduleProductsForProcessing();
 
+    //----------------------------------------------------------------------
+    // Method: scheduleHandedOutputs
+    //----------------------------------------------------------------------
+    void scheduleHandedOutputs();
+
+    //----------------------------------------------------------------------
+    // Method: scheduleProduct
+    //----------------------------------------------------------------------
+    bool scheduleProduct(string & prod, ProductMeta & meta);
+
+    //----------------------------------------------------------------------
+    // Method: storeScheduledProducts
+    //----------------------------------------------------------------------
+    void storeScheduledProducts(ProductMetaList & products);
+
+    //----------------------------------------------------------------------
+    // Method: createRelocator
+    //----------------------------------------------------------------------
+    void createRelocator();
+
     //----------------------------------------------------------------------
     // Method: archiveOutputs
     //----------------------------------------------------------------------
     void archiveOutputs();
 
+    //----------------------------------------------------------------------
+    // Method: storeArchivedOutputs
+    //----------------------------------------------------------------------
+    void storeArchivedOutputs();
+
     //----------------------------------------------------------------------
     // Method: transferRemoteLocalArchiveToCommander
     //----------------------------------------------------------------------
@@ -230,6 +258,7 @@ private:
     TaskOrchestrator * tskOrc;
     TaskManager * tskMng;
     DataManager * dataMng;
+    Relocator * relocator;
 
     MasterServer * httpServer;
     MasterRequester * httpRqstr;
@@ -246,8 +275,13 @@ private:
 
     Queue<string> outputProducts;
 
+    // Output products already moved to the archive by the relocator
+    std::mutex archivedMtx;
+    ProductMetaList archivedProducts;
+
     bool nodeInfoIsAvailable;
     json nodeInfo;
+    SnapshotPublisher nodeInfoSnapshot;
 
     typedef int(*SelectNodeFn)(Master*);
     SelectNodeFn selectNodeFn;
@@ -60,7 +60,11 @@ communication through that route:
 
 - /status (GET)
   Provides access from the clients to the Host information 
-  structure 
+  structure (supports ETag / If-None-Match)
+
+- /tstatus (GET)
+  Provides access from the clients to the Tasks information
+  structure (supports ETag / If-None-Match)
 
 - /
 
@@ -94,13 +98,29 @@ public:
     }
 };
 
+//----------------------------------------------------------------------
+// Function: snapshotResponse
+// Serves a status snapshot, or just 304 if the client already has it
+//----------------------------------------------------------------------
+static const HttpRespPtr snapshotResponse(const http_request& req,
+                                          SnapshotPtr snap)
+{
+    strResp * resp;
+    if (req.get_header("If-None-Match") == snap->etag) {
+        resp = new strResp("", 304);
+    } else {
+        resp = new strResp(snap->body, 200, "application/json");
+    }
+    resp->with_header("ETag", snap->etag);
+    return HttpRespPtr(resp);
+}
+
 class RscHostStatus : public http_resource {
 public:
     void setMasterHdl(Master * hdl) { mhdl = hdl; }
     
-    const HttpRespPtr render_GET(const http_request&) {
-        return HttpRespPtr(new strResp(mhdl->getHostInfo(), 200,
-                                       "application/json"));
+    const HttpRespPtr render_GET(const http_request& req) {
+        return snapshotResponse(req, mhdl->getHostInfo());
     }
 
     const HttpRespPtr render(const http_request&) {
@@ -114,9 +134,8 @@ class RscTaskStatus : public http_resource {
 public:
     void setTaskMngHdl(TaskManager * hdl) { thdl = hdl; }
     
-    const HttpRespPtr render_GET(const http_request&) {
-        return HttpRespPtr(new strResp(thdl->getTaskInfo(), 200,
-                                       "application/json"));
+    const HttpRespPtr render_GET(const http_request& req) {
+        return snapshotResponse(req, thdl->getTaskInfo());
     }
 
     const HttpRespPtr render(const http_request&) {
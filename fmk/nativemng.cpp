@@ -0,0 +1,459 @@
+/******************************************************************************
+ * File:    nativemng.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.NativeExecMng
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement NativeExecMng class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#include "nativemng.h"
+
+#include "str.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+extern char ** environ;
+
+#ifndef P_PIDFD
+#define P_PIDFD 3
+#endif
+
+static std::atomic<int> nativeProcCounter(0);
+
+//----------------------------------------------------------------------
+// Function: openPidFd
+// Returns a pidfd for the process, or -1 if not supported
+//----------------------------------------------------------------------
+static int openPidFd(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return (int)(syscall(SYS_pidfd_open, pid, 0));
+#else
+    return -1;
+#endif
+}
+
+//----------------------------------------------------------------------
+// Function: parseCpuList
+// Parses a cpuset list (i.e.: 0-3,6) into a CPU set
+//----------------------------------------------------------------------
+static bool parseCpuList(const std::string & list, cpu_set_t & cpus)
+{
+    CPU_ZERO(&cpus);
+    for (auto & item: str::split(list, ',')) {
+        size_t dash = item.find('-');
+        int from = std::atoi(item.c_str());
+        int to = ((dash == std::string::npos) ? from :
+                  std::atoi(item.c_str() + dash + 1));
+        if ((from < 0) || (to < from) || (to >= CPU_SETSIZE)) { return false; }
+        for (int c = from; c <= to; ++c) { CPU_SET(c, &cpus); }
+    }
+    return CPU_COUNT(&cpus) > 0;
+}
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+NativeExecMng::NativeExecMng(WorkArea & _wa, std::string _cgroupRoot,
+                             std::map<std::string, std::string> _cgroupLimits)
+    : DockerMng(_wa), cgroupRoot(_cgroupRoot), cgroupLimits(_cgroupLimits),
+      logger(Log::getLogger("natexec"))
+{
+}
+
+//----------------------------------------------------------------------
+// Destructor
+// Kills the processes still running, and releases all their resources
+//----------------------------------------------------------------------
+NativeExecMng::~NativeExecMng()
+{
+    for (auto & kv: procs) {
+        NativeProc & p = kv.second;
+        if (p.running) {
+            killpg(p.pid, SIGKILL);
+            waitpid(p.pid, nullptr, 0);
+        }
+        if (p.pidfd >= 0) { close(p.pidfd); }
+        if (! p.cgroup.empty()) { rmdir(p.cgroup.c_str()); }
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: createContainer
+// Launches the requested application as a child process, in its own
+// process group, in the working directory and with the environment
+// requested.  Its standard output and error go to native.log in the
+// working directory
+//----------------------------------------------------------------------
+bool NativeExecMng::createContainer(std::string img, std::vector<std::string> opts,
+                                    std::map<std::string, std::string> maps,
+                                    std::string exe, std::vector<std::string> args,
+                                    std::string & containerId, std::string & cmd_line)
+{
+    std::string workDir(".");
+    std::map<std::string, std::string> env;
+    json labels = json::object();
+    cpu_set_t cpus;
+    bool pinned = false;
+
+    for (size_t i = 0; i < opts.size(); ++i) {
+        std::string opt = opts.at(i);
+        std::string val;
+        size_t eq = opt.find('=');
+        if (opt == "--rm") {
+            continue;
+        } else if ((opt.compare(0, 2, "--") == 0) && (eq != std::string::npos)) {
+            val = opt.substr(eq + 1);
+            opt = opt.substr(0, eq);
+        } else if (i + 1 < opts.size()) {
+            val = opts.at(++i);
+        }
+
+        if ((opt == "--workdir") || (opt == "-w")) {
+            workDir = toHostPath(val, maps);
+        } else if ((opt == "--env") || (opt == "-e")) {
+            size_t p = val.find('=');
+            env[val.substr(0, p)] = ((p == std::string::npos) ? "" :
+                                     toHostPath(val.substr(p + 1), maps));
+        } else if ((opt == "--label") || (opt == "-l")) {
+            size_t p = val.find('=');
+            labels[val.substr(0, p)] = ((p == std::string::npos) ? "" :
+                                        val.substr(p + 1));
+        } else if (opt == "--cpuset-cpus") {
+            pinned = parseCpuList(val, cpus);
+        } else {
+            logger.debug("Container option %s ignored", opt.c_str());
+        }
+    }
+
+    exe = toHostPath(exe, maps);
+    for (auto & a: args) { a = toHostPath(a, maps); }
+    cmd_line = exe + " " + str::join(args, " ");
+
+    containerId = ("native-" + std::to_string(getpid()) + "-" +
+                   std::to_string(++nativeProcCounter));
+
+    // Everything the child needs is prepared before the fork
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(exe.c_str()));
+    for (auto & a: args) { argv.push_back(const_cast<char*>(a.c_str())); }
+    argv.push_back(nullptr);
+
+    std::vector<std::string> envStr;
+    for (char ** e = environ; *e != nullptr; ++e) {
+        std::string var(*e);
+        if (env.count(var.substr(0, var.find('='))) == 0) { envStr.push_back(var); }
+    }
+    for (auto & kv: env) { envStr.push_back(kv.first + "=" + kv.second); }
+    std::vector<char*> envp;
+    for (auto & s: envStr) { envp.push_back(const_cast<char*>(s.c_str())); }
+    envp.push_back(nullptr);
+
+    std::string logFile(workDir + "/native.log");
+    int logFd = open(logFile.c_str(),
+                     O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (logFd < 0) {
+        logger.error("Cannot open %s: %s", logFile.c_str(), strerror(errno));
+        return false;
+    }
+
+    std::string cgroup;
+    int cgFd = -1;
+    if ((! cgroupRoot.empty()) && createCgroup(containerId, cgroup)) {
+        cgFd = open((cgroup + "/cgroup.procs").c_str(), O_WRONLY | O_CLOEXEC);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Child: only async-signal-safe calls from here on
+        setpgid(0, 0);
+        if (cgFd >= 0) { (void)(write(cgFd, "0", 1)); }
+        if (pinned) { sched_setaffinity(0, sizeof(cpus), &cpus); }
+        if (chdir(workDir.c_str()) < 0) { _exit(127); }
+        int nullFd = open("/dev/null", O_RDONLY);
+        if (nullFd >= 0) { dup2(nullFd, 0); }
+        dup2(logFd, 1);
+        dup2(logFd, 2);
+        execvpe(argv[0], argv.data(), envp.data());
+        _exit(127);
+    }
+
+    close(logFd);
+    if (cgFd >= 0) { close(cgFd); }
+
+    if (pid < 0) {
+        logger.error("Cannot fork process for %s: %s", exe.c_str(),
+                     strerror(errno));
+        if (! cgroup.empty()) { rmdir(cgroup.c_str()); }
+        return false;
+    }
+    setpgid(pid, pid);
+
+    NativeProc p;
+    p.pid       = pid;
+    p.pidfd     = openPidFd(pid);
+    p.running   = true;
+    p.exitCode  = 0;
+    p.oomKilled = false;
+    p.cgroup    = cgroup;
+    p.startedAt = timeStamp();
+    p.config    = {{"Image", img}, {"WorkingDir", workDir},
+                   {"Env", json::array()}, {"Labels", labels}};
+    for (auto & kv: env) { p.config["Env"].push_back(kv.first + "=" + kv.second); }
+    p.config["Cmd"] = json::array({exe});
+    for (auto & a: args) { p.config["Cmd"].push_back(a); }
+    procs[containerId] = p;
+
+    logger.debug("Process %d launched for %s", (int)(pid), containerId.c_str());
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: getInfo
+// Retrieves the state of the process, as container inspection info
+//----------------------------------------------------------------------
+bool NativeExecMng::getInfo(std::string id, std::stringstream & info)
+{
+    json summary;
+    bool ok = inspect(id, summary);
+    info.str(ok ? summary.dump() : "");
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// Method: inspect
+// Retrieves the state of the process, as container inspection info.
+// Processes killed by a signal are reported with exit code 128 + signal
+//----------------------------------------------------------------------
+bool NativeExecMng::inspect(std::string id, json & summary)
+{
+    auto it = procs.find(id);
+    if (it == procs.end()) { return false; }
+    NativeProc & p = it->second;
+    update(p);
+
+    json state = {{"Status", p.running ? "running" : "exited"},
+                  {"Running", p.running},
+                  {"Paused", false},
+                  {"OOMKilled", p.oomKilled},
+                  {"Dead", false},
+                  {"Pid", p.running ? (int)(p.pid) : 0},
+                  {"ExitCode", p.exitCode},
+                  {"StartedAt", p.startedAt},
+                  {"FinishedAt", p.finishedAt}};
+
+    json cmd = p.config["Cmd"];
+    summary = {{"Id", id}, {"State", state},
+               {"Path", cmd.at(0)}, {"Args", json::array()},
+               {"Config", p.config}};
+    for (size_t i = 1; i < cmd.size(); ++i) { summary["Args"].push_back(cmd.at(i)); }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: kill
+// Kill the process, along with all the processes of its cgroup (if
+// any) or its process group
+//----------------------------------------------------------------------
+bool NativeExecMng::kill(std::string id)
+{
+    auto it = procs.find(id);
+    if (it == procs.end()) { return false; }
+    NativeProc & p = it->second;
+    update(p);
+    if (! p.running) { return false; }
+
+    if (! p.cgroup.empty()) {
+        int fd = open((p.cgroup + "/cgroup.kill").c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            bool done = (write(fd, "1", 1) == 1);
+            close(fd);
+            if (done) { return true; }
+        }
+    }
+    return (killpg(p.pid, SIGKILL) == 0);
+}
+
+//----------------------------------------------------------------------
+// Method: remove
+// Forgets an exited process, and removes its cgroup
+//----------------------------------------------------------------------
+bool NativeExecMng::remove(std::string id)
+{
+    auto it = procs.find(id);
+    if (it == procs.end()) { return false; }
+    NativeProc & p = it->second;
+    update(p);
+    if (p.running) { return false; }
+
+    if (p.pidfd >= 0) { close(p.pidfd); }
+    if ((! p.cgroup.empty()) && (rmdir(p.cgroup.c_str()) < 0)) {
+        logger.warn("Cannot remove cgroup %s: %s", p.cgroup.c_str(),
+                    strerror(errno));
+    }
+    procs.erase(it);
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: getContainerList
+// Retrieves list of process ids in the form of a vector
+//----------------------------------------------------------------------
+bool NativeExecMng::getContainerList(std::vector<std::string> & contList)
+{
+    for (auto & kv: procs) { contList.push_back(kv.first); }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: toHostPath
+// Maps a path inside the container (alone, or as the value of a
+// var=value argument) to the corresponding host path
+//----------------------------------------------------------------------
+std::string NativeExecMng::toHostPath(const std::string & s,
+                                      std::map<std::string, std::string> & maps)
+{
+    size_t eq = s.find('=');
+    size_t start = ((s.empty() || (s[0] == '/') || (eq == std::string::npos)) ?
+                    0 : eq + 1);
+    for (auto & kv: maps) {
+        std::string imgPath = kv.second.substr(0, kv.second.find(':'));
+        if ((s.compare(start, imgPath.size(), imgPath) == 0) &&
+            ((s.size() == start + imgPath.size()) ||
+             (s[start + imgPath.size()] == '/'))) {
+            return s.substr(0, start) + kv.first + s.substr(start + imgPath.size());
+        }
+    }
+    return s;
+}
+
+//----------------------------------------------------------------------
+// Method: createCgroup
+// Creates the cgroup for the process, and sets its limits
+//----------------------------------------------------------------------
+bool NativeExecMng::createCgroup(const std::string & id, std::string & cgroup)
+{
+    cgroup = cgroupRoot + "/" + id;
+    if (mkdir(cgroup.c_str(), 0755) < 0) {
+        logger.warn("Cannot create cgroup %s: %s", cgroup.c_str(),
+                    strerror(errno));
+        cgroup.clear();
+        return false;
+    }
+
+    for (auto & kv: cgroupLimits) {
+        std::string file(cgroup + "/" + kv.first);
+        int fd = open(file.c_str(), O_WRONLY | O_CLOEXEC);
+        if ((fd < 0) ||
+            (write(fd, kv.second.c_str(), kv.second.size()) < 0)) {
+            logger.warn("Cannot set %s to %s: %s", file.c_str(),
+                        kv.second.c_str(), strerror(errno));
+        }
+        if (fd >= 0) { close(fd); }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: update
+// Checks (without blocking) whether the process has exited, using its
+// pidfd if available, and collects its exit status
+//----------------------------------------------------------------------
+void NativeExecMng::update(NativeProc & p)
+{
+    if (! p.running) { return; }
+
+    siginfo_t si;
+    std::memset(&si, 0, sizeof(si));
+    int r = -1;
+    if (p.pidfd >= 0) {
+        struct pollfd pfd;
+        pfd.fd = p.pidfd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 0) == 0) { return; }
+        r = waitid((idtype_t)(P_PIDFD), (id_t)(p.pidfd), &si, WEXITED | WNOHANG);
+    }
+    if (r < 0) {
+        r = waitid(P_PID, (id_t)(p.pid), &si, WEXITED | WNOHANG);
+    }
+    if ((r < 0) || (si.si_pid == 0)) { return; }
+
+    p.running = false;
+    p.exitCode = ((si.si_code == CLD_EXITED) ? si.si_status :
+                  128 + si.si_status);
+    p.finishedAt = timeStamp();
+
+    if (! p.cgroup.empty()) {
+        std::string file(p.cgroup + "/memory.events");
+        int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            char buf[512];
+            ssize_t n = read(fd, buf, sizeof(buf) - 1);
+            close(fd);
+            buf[(n > 0) ? n : 0] = 0;
+            const char * oom = std::strstr(buf, "oom_kill ");
+            p.oomKilled = ((oom != nullptr) && (std::atoi(oom + 9) > 0));
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: timeStamp
+// Returns the current time in the format used by Docker
+//----------------------------------------------------------------------
+std::string NativeExecMng::timeStamp()
+{
+    char buf[32];
+    time_t now = time(nullptr);
+    struct tm t;
+    gmtime_r(&now, &t);
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &t);
+    return std::string(buf);
+}
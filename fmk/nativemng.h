@@ -0,0 +1,180 @@
+/******************************************************************************
+ * File:    nativemng.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.NativeExecMng
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare NativeExecMng class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#ifndef NATIVEMNG_H
+#define NATIVEMNG_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   none
+//------------------------------------------------------------
+#include <vector>
+#include <map>
+#include <string>
+#include <sstream>
+
+#include <sys/types.h>
+
+//------------------------------------------------------------
+// Topic: External packages
+//   none
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//   none
+//------------------------------------------------------------
+#include "dckmng.h"
+#include "log.h"
+
+//==========================================================================
+// Class: NativeExecMng
+// Executor that runs the processors directly on the host, as child
+// processes, instead of in containers.  It accepts the same requests as
+// the container managers: paths inside the container are mapped back
+// to the host paths, and the process state is reported as a container
+// state, so that the tasks follow the same status model.  Each process
+// can optionally be placed in its own cgroup (v2), with CPU and memory
+// limits.  Exit is detected through a pidfd where available
+//==========================================================================
+class NativeExecMng : public DockerMng {
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    NativeExecMng(WorkArea & _wa,
+                  std::string _cgroupRoot = std::string(""),
+                  std::map<std::string, std::string> _cgroupLimits = {});
+
+    //----------------------------------------------------------------------
+    // Destructor
+    //----------------------------------------------------------------------
+    virtual ~NativeExecMng();
+
+    //----------------------------------------------------------------------
+    // Method: createContainer
+    // Launches the requested application as a child process.  The
+    // options are given as for docker run
+    //----------------------------------------------------------------------
+    virtual bool createContainer(std::string img, std::vector<std::string> opts,
+                                 std::map<std::string, std::string> maps,
+                                 std::string exe, std::vector<std::string> args,
+                                 std::string & containerId, std::string & cmd_line);
+
+    //----------------------------------------------------------------------
+    // Method: getInfo
+    // Retrieves the state of the process, as container inspection info
+    //----------------------------------------------------------------------
+    virtual bool getInfo(std::string id, std::stringstream & info);
+
+    //----------------------------------------------------------------------
+    // Method: inspect
+    // Retrieves the state of the process, as container inspection info
+    //----------------------------------------------------------------------
+    virtual bool inspect(std::string id, json & summary);
+
+    //----------------------------------------------------------------------
+    // Method: kill
+    // Kill the process (and its process group)
+    //----------------------------------------------------------------------
+    virtual bool kill(std::string id);
+
+    //----------------------------------------------------------------------
+    // Method: remove
+    // Forgets an exited process, and removes its cgroup
+    //----------------------------------------------------------------------
+    virtual bool remove(std::string id);
+
+    //----------------------------------------------------------------------
+    // Method: getContainerList
+    // Retrieves list of process ids in the form of a vector
+    //----------------------------------------------------------------------
+    virtual bool getContainerList(std::vector<std::string> & contList);
+
+private:
+    struct NativeProc {
+        pid_t       pid;
+        int         pidfd;
+        bool        running;
+        int         exitCode;
+        bool        oomKilled;
+        std::string cgroup;
+        std::string startedAt;
+        std::string finishedAt;
+        json        config;
+    };
+
+    //----------------------------------------------------------------------
+    // Method: toHostPath
+    //----------------------------------------------------------------------
+    std::string toHostPath(const std::string & s,
+                           std::map<std::string, std::string> & maps);
+
+    //----------------------------------------------------------------------
+    // Method: createCgroup
+    //----------------------------------------------------------------------
+    bool createCgroup(const std::string & id, std::string & cgroup);
+
+    //----------------------------------------------------------------------
+    // Method: update
+    //----------------------------------------------------------------------
+    void update(NativeProc & p);
+
+    //----------------------------------------------------------------------
+    // Method: timeStamp
+    //----------------------------------------------------------------------
+    std::string timeStamp();
+
+private:
+    std::string cgroupRoot;
+    std::map<std::string, std::string> cgroupLimits;
+
+    std::map<std::string, NativeProc> procs;
+
+    Logger logger;
+};
+
+#endif  /* NATIVEMNG_H */
@@ -0,0 +1,76 @@
+/******************************************************************************
+ * File:    outhandoff.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.OutputHandoff
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement OutputHandoff class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#include "outhandoff.h"
+
+//----------------------------------------------------------------------
+// Method: push
+//----------------------------------------------------------------------
+void OutputHandoff::push(ProductMeta & meta, bool needsVersion)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        outputs.push_back(HandedOutput {meta, needsVersion});
+    }
+    cv.notify_one();
+}
+
+//----------------------------------------------------------------------
+// Method: retrieve
+// Takes all the outputs handed over so far
+//----------------------------------------------------------------------
+bool OutputHandoff::retrieve(std::vector<HandedOutput> & v)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    v.clear();
+    v.swap(outputs);
+    return ! v.empty();
+}
+
+//----------------------------------------------------------------------
+// Method: waitUntil
+// Waits until there are outputs (returning true) or the deadline
+//----------------------------------------------------------------------
+bool OutputHandoff::waitUntil(std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    return cv.wait_until(lock, deadline, [this](){ return ! outputs.empty(); });
+}
@@ -0,0 +1,112 @@
+/******************************************************************************
+ * File:    outhandoff.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.OutputHandoff
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare OutputHandoff class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#ifndef OUTPUTHANDOFF_H
+#define OUTPUTHANDOFF_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - vector
+//   - mutex
+//   - condition_variable
+//   - chrono
+//------------------------------------------------------------
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+#include "types.h"
+
+//==========================================================================
+// Struct: HandedOutput
+// Output product of a task, with its already parsed metadata
+//==========================================================================
+struct HandedOutput {
+    ProductMeta meta;
+    bool        needsVersion;
+};
+
+//==========================================================================
+// Class: OutputHandoff
+// Queue of the outputs of the tasks of the node, handed over by the
+// agents (and the output watcher) directly to the main loop, which
+// schedules them without a round trip through the inbox folder.  The
+// main loop can wait on it, so that it is woken up by new outputs
+//==========================================================================
+class OutputHandoff {
+
+public:
+    //----------------------------------------------------------------------
+    // Method: push
+    //----------------------------------------------------------------------
+    void push(ProductMeta & meta, bool needsVersion);
+
+    //----------------------------------------------------------------------
+    // Method: retrieve
+    // Takes all the outputs handed over so far
+    //----------------------------------------------------------------------
+    bool retrieve(std::vector<HandedOutput> & outputs);
+
+    //----------------------------------------------------------------------
+    // Method: waitUntil
+    // Waits until there are outputs (returning true) or the deadline
+    //----------------------------------------------------------------------
+    bool waitUntil(std::chrono::steady_clock::time_point deadline);
+
+private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<HandedOutput> outputs;
+};
+
+#endif // OUTPUTHANDOFF_H
@@ -0,0 +1,222 @@
+/******************************************************************************
+ * File:    outwatch.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.OutputWatcher
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement OutputWatcher class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#include "outwatch.h"
+
+#include "prodloc.h"
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+OutputWatcher::OutputWatcher(WorkArea & _wa, OutputHandoff * _handoff,
+                             std::string _marker)
+    : wa(_wa), handoff(_handoff), marker(_marker), inotifyFd(-1), stopFd(-1), quit(false),
+      logger(Log::getLogger("outwatch"))
+{
+}
+
+//----------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------
+OutputWatcher::~OutputWatcher()
+{
+    stop();
+}
+
+//----------------------------------------------------------------------
+// Method: start
+//----------------------------------------------------------------------
+bool OutputWatcher::start()
+{
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ((inotifyFd < 0) || (stopFd < 0)) {
+        logger.error("Cannot create output watcher: %s", strerror(errno));
+        return false;
+    }
+    watcher = std::thread(&OutputWatcher::run, this);
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: stop
+//----------------------------------------------------------------------
+void OutputWatcher::stop()
+{
+    if (watcher.joinable()) {
+        quit = true;
+        uint64_t one = 1;
+        if (write(stopFd, &one, sizeof(one)) < 0) {}
+        watcher.join();
+    }
+    if (inotifyFd >= 0) { close(inotifyFd); inotifyFd = -1; }
+    if (stopFd >= 0) { close(stopFd); stopFd = -1; }
+}
+
+//----------------------------------------------------------------------
+// Method: watch
+// Starts watching the output folder of the task
+//----------------------------------------------------------------------
+bool OutputWatcher::watch(const std::string & taskFolder)
+{
+    std::string outFolder(taskFolder + "/out");
+    std::lock_guard<std::mutex> lock(mtx);
+    int wd = inotify_add_watch(inotifyFd, outFolder.c_str(),
+                               IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+    if (wd < 0) {
+        logger.warn("Cannot watch output folder %s: %s",
+                    outFolder.c_str(), strerror(errno));
+        return false;
+    }
+    folders[wd] = taskFolder;
+    watches[taskFolder] = wd;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: unwatch
+// Stops watching the output folder of the task.  On return, no more
+// outputs of the task are handled by the watcher, and the outputs
+// already handed over are returned
+//----------------------------------------------------------------------
+void OutputWatcher::unwatch(const std::string & taskFolder,
+                            std::set<std::string> & handedOver)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = watches.find(taskFolder);
+    if (it == watches.end()) { return; }
+    inotify_rm_watch(inotifyFd, it->second);
+    folders.erase(it->second);
+    watches.erase(it);
+
+    auto jt = handed.find(taskFolder);
+    if (jt != handed.end()) {
+        handedOver.swap(jt->second);
+        handed.erase(jt);
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: run
+//----------------------------------------------------------------------
+void OutputWatcher::run()
+{
+    alignas(struct inotify_event) char buf[16384];
+    struct pollfd fds[2] = { {inotifyFd, POLLIN, 0}, {stopFd, POLLIN, 0} };
+
+    while (! quit) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) { continue; }
+            logger.error("Output watcher failed: %s", strerror(errno));
+            return;
+        }
+        if (fds[1].revents != 0) { break; }
+
+        ssize_t len;
+        while ((len = read(inotifyFd, buf, sizeof(buf))) > 0) {
+            processEvents(buf, len);
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: processEvents
+// Moves the completed outputs of the still watched folders.  The lock
+// is held, so that a task being unwatched is not moved meanwhile
+//----------------------------------------------------------------------
+void OutputWatcher::processEvents(char * buf, ssize_t len)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    for (char * p = buf; p < buf + len;) {
+        struct inotify_event * ev = (struct inotify_event *)(p);
+        p += sizeof(struct inotify_event) + ev->len;
+
+        auto it = folders.find(ev->wd);
+        if ((it == folders.end()) || (ev->len < 1)) { continue; }
+
+        std::string name(ev->name);
+        if (name.at(0) == '.') { continue; }  // Temporary files
+
+        std::string file(it->second + "/out/" + name);
+        if (marker.empty()) {
+            publish(it->second, file);
+        } else if ((name.length() > marker.length()) &&
+                   (name.compare(name.length() - marker.length(),
+                                 marker.length(), marker) == 0)) {
+            publish(it->second, file.substr(0, file.length() - marker.length()));
+            unlink(file.c_str());
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: publish
+// Hands the output over, or moves it to the local inbox, as done at
+// the end of the task.  Handed over outputs are left in place, and
+// are then no longer watched
+//----------------------------------------------------------------------
+void OutputWatcher::publish(const std::string & taskFolder, std::string file)
+{
+    if (access(file.c_str(), F_OK) != 0) { return; }  // Already moved
+
+    ProductMeta meta;
+    bool needsVersion;
+    if (! fns.parse(file, meta, needsVersion)) {
+        logger.error("Cannot parse file name for product %s", file.c_str());
+        return;
+    }
+    if (handoff != nullptr) {
+        if (! handed[taskFolder].insert(file).second) { return; }
+        handoff->push(meta, needsVersion);
+        logger.debug("Output %s handed over before task end", file.c_str());
+        return;
+    }
+    if (! ProductLocator::toLocalInbox(meta, wa)) {
+        logger.error("Cannot move %s to local inbox folder", file.c_str());
+        return;
+    }
+    logger.debug("Output %s moved to local inbox before task end", file.c_str());
+}
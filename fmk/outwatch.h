@@ -0,0 +1,162 @@
+/******************************************************************************
+ * File:    outwatch.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.OutputWatcher
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare OutputWatcher class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#ifndef OUTPUTWATCHER_H
+#define OUTPUTWATCHER_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//   - map
+//   - set
+//   - thread
+//   - mutex
+//   - atomic
+//------------------------------------------------------------
+#include <string>
+#include <map>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+#include "wa.h"
+#include "fnamespec.h"
+#include "outhandoff.h"
+#include "log.h"
+
+//==========================================================================
+// Class: OutputWatcher
+// Watches (with inotify) the output folders of the running tasks of the
+// node, and hands each output over to the main loop (or moves it to the
+// local inbox) as soon as it is complete, so that the rules it triggers do not wait for the end of
+// the task.  An output is complete when it is closed after writing, or
+// moved into the folder, or, if a marker suffix is set, when the
+// processor creates the marker file <output><marker>
+//==========================================================================
+class OutputWatcher {
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    OutputWatcher(WorkArea & _wa, OutputHandoff * _handoff,
+                  std::string _marker = std::string());
+
+    //----------------------------------------------------------------------
+    // Destructor
+    //----------------------------------------------------------------------
+    virtual ~OutputWatcher();
+
+    //----------------------------------------------------------------------
+    // Method: start
+    //----------------------------------------------------------------------
+    bool start();
+
+    //----------------------------------------------------------------------
+    // Method: stop
+    //----------------------------------------------------------------------
+    void stop();
+
+    //----------------------------------------------------------------------
+    // Method: watch
+    // Starts watching the output folder of the task
+    //----------------------------------------------------------------------
+    bool watch(const std::string & taskFolder);
+
+    //----------------------------------------------------------------------
+    // Method: unwatch
+    // Stops watching the output folder of the task.  On return, no more
+    // outputs of the task are handled by the watcher, and the outputs
+    // already handed over are returned
+    //----------------------------------------------------------------------
+    void unwatch(const std::string & taskFolder,
+                 std::set<std::string> & handedOver);
+
+private:
+    //----------------------------------------------------------------------
+    // Method: run
+    //----------------------------------------------------------------------
+    void run();
+
+    //----------------------------------------------------------------------
+    // Method: processEvents
+    //----------------------------------------------------------------------
+    void processEvents(char * buf, ssize_t len);
+
+    //----------------------------------------------------------------------
+    // Method: publish
+    //----------------------------------------------------------------------
+    void publish(const std::string & taskFolder, std::string file);
+
+private:
+    WorkArea wa;
+    OutputHandoff * handoff;
+    std::string marker;
+
+    int inotifyFd;
+    int stopFd;
+
+    std::mutex mtx;
+    std::map<int, std::string> folders;
+    std::map<std::string, int> watches;
+    std::map<std::string, std::set<std::string>> handed;
+
+    FileNameSpec fns;
+
+    std::atomic<bool> quit;
+    std::thread watcher;
+
+    Logger logger;
+};
+
+#endif // OUTPUTWATCHER_H
@@ -0,0 +1,245 @@
+/******************************************************************************
+ * File:    proccfg.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.ProcessorConfig
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement ProcessorConfig and ProcessorConfigCache classes
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#include "proccfg.h"
+
+#include "str.h"
+#include "jsonfhdl.h"
+
+static const char * TaskPlaceholders[] = { "{input}", "{output}", "{log}" };
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+ProcessorConfig::ProcessorConfig()
+    : dev(0), ino(0), mtime(0), size(0)
+{
+}
+
+//----------------------------------------------------------------------
+// Method: compile
+// Compiles the configuration, with the processors area mounted in
+// the container at procAreaImg
+//----------------------------------------------------------------------
+bool ProcessorConfig::compile(Config & cfg, const std::string & procArea,
+                              const std::string & procAreaImg)
+{
+    for (auto & key: {"input", "output", "log", "processor",
+                      "script", "args", "image", "exe"}) {
+        if ((cfg.count(key) < 1) || (! cfg[key].is_string())) { return false; }
+    }
+
+    image = cfg["image"].get<std::string>();
+    exe   = cfg["exe"].get<std::string>();
+    input = cfg["input"].get<std::string>();
+    if (! (compileItem(cfg, "output", output) &&
+           compileItem(cfg, "log", log))) { return false; }
+
+    // Resolve all the placeholders but the task inputs, outputs and logs
+    std::string p_args = cfg["args"].get<std::string>();
+    for (auto & kv: cfg.items()) {
+        if ((kv.key() == "input") || (kv.key() == "output") ||
+            (kv.key() == "log") || (! kv.value().is_string())) { continue; }
+        p_args = str::replaceAll(p_args, "{" + kv.key() + "}",
+                                 kv.value().get<std::string>());
+    }
+    p_args.insert(0, (procAreaImg + "/" + cfg["processor"].get<std::string>() +
+                      "/" + cfg["script"].get<std::string>() + " "));
+
+    args.clear();
+    for (auto & s: str::split(p_args, ' ')) {
+        bool perTask = false;
+        for (auto & ph: TaskPlaceholders) {
+            perTask = perTask || (s.find(ph) != std::string::npos);
+        }
+        args.push_back(ArgToken {s, perTask});
+    }
+
+    mapping = { {procArea, procAreaImg} };
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: compileItem
+// Splits the substitution rules of the item, and applies them at once
+// if they are not based on the task inputs, outputs or logs
+//----------------------------------------------------------------------
+bool ProcessorConfig::compileItem(Config & cfg, const std::string & key,
+                                  FileItem & item)
+{
+    item.expr = cfg[key].get<std::string>();
+    item.hasRules = isSubstitutionRules(item.expr);
+    item.rules.clear();
+    item.files.clear();
+    if (! item.hasRules) { return true; }
+
+    auto v = str::split(item.expr.substr(1, item.expr.length() - 2), ':');
+    if (v.size() < 2) { return false; }
+    item.fromVar = v.at(0);
+    for (auto & rule: str::split(v.at(1), ',')) {
+        size_t pos = rule.find("=>");
+        if (pos == std::string::npos) { return false; }
+        item.rules.push_back(std::make_pair(rule.substr(0, pos),
+                                            rule.substr(pos + 2)));
+    }
+
+    if ((item.fromVar != "input") && (item.fromVar != "output") &&
+        (item.fromVar != "log")) {
+        if ((cfg.count(item.fromVar) < 1) ||
+            (! cfg[item.fromVar].is_string())) { return false; }
+        item.files = str::split(substitute(cfg[item.fromVar].get<std::string>(),
+                                           item.rules), ' ');
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: applyRules
+// Gets the files of an item with substitution rules, from the task
+// inputs, outputs and logs
+//----------------------------------------------------------------------
+std::vector<std::string>
+ProcessorConfig::applyRules(const FileItem & item,
+                            const std::vector<std::string> & inputs,
+                            const std::vector<std::string> & outputs,
+                            const std::vector<std::string> & logs) const
+{
+    const std::vector<std::string> * from = nullptr;
+    if (item.fromVar == "input") {
+        from = &inputs;
+    } else if (item.fromVar == "output") {
+        from = &outputs;
+    } else if (item.fromVar == "log") {
+        from = &logs;
+    } else {
+        return item.files;
+    }
+    return str::split(substitute(str::join(*from, " "), item.rules), ' ');
+}
+
+//----------------------------------------------------------------------
+// Method: buildArgs
+// Gets the processor arguments for the given task inputs, outputs
+// and logs (comma separated lists)
+//----------------------------------------------------------------------
+std::vector<std::string> ProcessorConfig::buildArgs(const std::string & input,
+                                                    const std::string & output,
+                                                    const std::string & log) const
+{
+    std::vector<std::string> v;
+    v.reserve(args.size());
+    for (auto & arg: args) {
+        if (! arg.perTask) {
+            v.push_back(arg.text);
+            continue;
+        }
+        std::string s = str::replaceAll(arg.text, TaskPlaceholders[0], input);
+        s = str::replaceAll(s, TaskPlaceholders[1], output);
+        v.push_back(str::replaceAll(s, TaskPlaceholders[2], log));
+    }
+    return v;
+}
+
+//----------------------------------------------------------------------
+// Method: isSubstitutionRules
+// Determine if a certain item has rules inside
+//----------------------------------------------------------------------
+bool ProcessorConfig::isSubstitutionRules(const std::string & item)
+{
+    if (item.length() < 1) { return false; }
+    return (item[0] == '{') && (item[item.length() - 1] == '}');
+}
+
+//----------------------------------------------------------------------
+// Method: substitute
+//----------------------------------------------------------------------
+std::string
+ProcessorConfig::substitute(std::string value,
+                            const std::vector<std::pair<std::string,
+                                                        std::string>> & rules)
+{
+    for (auto & rule: rules) {
+        value = str::replaceAll(value, rule.first, rule.second);
+    }
+    return value;
+}
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+ProcessorConfigCache::ProcessorConfigCache(const std::string & _procArea,
+                                           const std::string & _procAreaImg)
+    : procArea(_procArea), procAreaImg(_procAreaImg)
+{
+}
+
+//----------------------------------------------------------------------
+// Method: get
+// Returns the compiled configuration of the processor, as read from
+// the given file, or null if it cannot be read
+//----------------------------------------------------------------------
+std::shared_ptr<const ProcessorConfig>
+ProcessorConfigCache::get(const std::string & proc, const std::string & cfgFile)
+{
+    struct stat st;
+    if (stat(cfgFile.c_str(), &st) < 0) { return nullptr; }
+
+    auto it = cfgs.find(proc);
+    if ((it != cfgs.end()) &&
+        (it->second->dev == st.st_dev) && (it->second->ino == st.st_ino) &&
+        (it->second->mtime == st.st_mtime) && (it->second->size == st.st_size)) {
+        return it->second;
+    }
+
+    JsonFileHandler jFile(cfgFile);
+    if (! jFile.read()) { return nullptr; }
+    Config cfg = jFile.getData();
+
+    auto pcfg = std::make_shared<ProcessorConfig>();
+    if (! pcfg->compile(cfg, procArea, procAreaImg)) { return nullptr; }
+    pcfg->dev   = st.st_dev;
+    pcfg->ino   = st.st_ino;
+    pcfg->mtime = st.st_mtime;
+    pcfg->size  = st.st_size;
+
+    cfgs[proc] = pcfg;
+    return pcfg;
+}
@@ -0,0 +1,203 @@
+/******************************************************************************
+ * File:    proccfg.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.ProcessorConfig
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare ProcessorConfig and ProcessorConfigCache classes
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#ifndef PROCESSORCONFIG_H
+#define PROCESSORCONFIG_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//   - vector
+//   - map
+//   - memory
+//------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+#include <sys/stat.h>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+#include "types.h"
+
+//==========================================================================
+// Class: ProcessorConfig
+// Processor configuration file, compiled once: the placeholders of the
+// arguments that do not depend on the task are already resolved, the
+// substitution rules are split, and the static folder mapping is built.
+// Only the inputs, outputs and logs remain to be set for each task
+//==========================================================================
+class ProcessorConfig {
+
+public:
+    //----------------------------------------------------------------------
+    // Struct: FileItem
+    // Expression for a set of task files: either a file expression
+    // (i.e.: in/*.fits), or substitution rules on another entry (i.e.:
+    // {input:in/=>out/,.fits=>.log}).  Rules on an entry that does not
+    // depend on the task are already applied
+    //----------------------------------------------------------------------
+    struct FileItem {
+        std::string expr;
+        bool        hasRules;
+        std::string fromVar;
+        std::vector<std::pair<std::string, std::string>> rules;
+        std::vector<std::string> files;
+    };
+
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    ProcessorConfig();
+
+    //----------------------------------------------------------------------
+    // Method: compile
+    // Compiles the configuration, with the processors area mounted in
+    // the container at procAreaImg
+    //----------------------------------------------------------------------
+    bool compile(Config & cfg, const std::string & procArea,
+                 const std::string & procAreaImg);
+
+    //----------------------------------------------------------------------
+    // Method: applyRules
+    // Gets the files of an item with substitution rules, from the task
+    // inputs, outputs and logs
+    //----------------------------------------------------------------------
+    std::vector<std::string> applyRules(const FileItem & item,
+                                        const std::vector<std::string> & inputs,
+                                        const std::vector<std::string> & outputs,
+                                        const std::vector<std::string> & logs) const;
+
+    //----------------------------------------------------------------------
+    // Method: buildArgs
+    // Gets the processor arguments for the given task inputs, outputs
+    // and logs (comma separated lists)
+    //----------------------------------------------------------------------
+    std::vector<std::string> buildArgs(const std::string & input,
+                                       const std::string & output,
+                                       const std::string & log) const;
+
+    //----------------------------------------------------------------------
+    // Method: isSubstitutionRules
+    // Determine if a certain item has rules inside
+    //----------------------------------------------------------------------
+    static bool isSubstitutionRules(const std::string & item);
+
+public:
+    std::string image;
+    std::string exe;
+    std::string input;
+    FileItem    output;
+    FileItem    log;
+    std::map<std::string, std::string> mapping;
+
+    // Identity of the file it was compiled from
+    dev_t  dev;
+    ino_t  ino;
+    time_t mtime;
+    off_t  size;
+
+private:
+    //----------------------------------------------------------------------
+    // Method: compileItem
+    //----------------------------------------------------------------------
+    bool compileItem(Config & cfg, const std::string & key, FileItem & item);
+
+    //----------------------------------------------------------------------
+    // Method: substitute
+    //----------------------------------------------------------------------
+    static std::string substitute(std::string value,
+                                  const std::vector<std::pair<std::string,
+                                                              std::string>> & rules);
+
+private:
+    // Argument, and whether it has task placeholders to replace
+    struct ArgToken {
+        std::string text;
+        bool        perTask;
+    };
+
+    std::vector<ArgToken> args;
+};
+
+//==========================================================================
+// Class: ProcessorConfigCache
+// Compiled configurations of the processors, indexed by processor name.
+// A configuration is compiled again when its file changes (the task
+// configuration files are hard links to a master copy, so the file
+// identity only changes when the processor configuration does)
+//==========================================================================
+class ProcessorConfigCache {
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    ProcessorConfigCache(const std::string & _procArea,
+                         const std::string & _procAreaImg);
+
+    //----------------------------------------------------------------------
+    // Method: get
+    // Returns the compiled configuration of the processor, as read from
+    // the given file, or null if it cannot be read
+    //----------------------------------------------------------------------
+    std::shared_ptr<const ProcessorConfig> get(const std::string & proc,
+                                               const std::string & cfgFile);
+
+private:
+    std::string procArea;
+    std::string procAreaImg;
+
+    std::map<std::string, std::shared_ptr<const ProcessorConfig>> cfgs;
+};
+
+#endif // PROCESSORCONFIG_H
@@ -67,12 +67,14 @@ ProcessingNetwork::ProcessingNetwork(Config & _cfg, string & _name, int _bMode)
         nodeServerUrl.push_back(url);
         if (name == commander) { commanderUrl = url; }
         nodeNumOfAgents.push_back(xo["agents"].get<int>());
+        nodeAgentSlots.push_back(xo.value("slots", 1));
     }
     numOfNodes = nodeName.size();
 
     commanderNum = indexOf<std::string>(nodeName, commander);
     thisNodeNum = indexOf<std::string>(nodeName, id);
     thisNodeNumOfAgents = nodeNumOfAgents[thisNodeNum];
+    thisNodeAgentSlots = nodeAgentSlots[thisNodeNum];
     thisNodeAddress = nodeAddress[thisNodeNum];
     thisNodePort = nodePort[thisNodeNum];
 
@@ -93,12 +93,14 @@ public:
     vector<string> nodeServerUrl;
     vector<int> nodePort;
     vector<int> nodeNumOfAgents;
+    vector<int> nodeAgentSlots;
 
     int numOfNodes;
 
     int commanderNum;
     int thisNodeNum;
     int thisNodeNumOfAgents;
+    int thisNodeAgentSlots;
     string thisNodeAddress;
     int thisNodePort;
 
@@ -42,6 +42,8 @@
 #include "rwc.h"
 #include "voshdl.h"
 #include "filetools.h"
+#include "copyeng.h"
+#include "log.h"
 
 #include <unistd.h>
 #include <cassert>
@@ -53,6 +55,11 @@
 #include <cerrno>
 #include <cstring>
 #include <libgen.h>
+#include <poll.h>
+#include <sys/inotify.h>
+
+#include <chrono>
+#include <thread>
 
 #define TRACES
 //#undef  TRACES
@@ -67,6 +74,8 @@ std::string ProductLocator::master_address;
 std::string ProductLocator::remote_address;
 bool ProductLocator::isRemote = false;
 
+const int ProductLocator::DefaultFileWait = 3000;
+
 //----------------------------------------------------------------------
 // Method: toLocalArchive
 //----------------------------------------------------------------------
@@ -161,28 +170,11 @@ int ProductLocator::relocate(std::string & sFrom, std::string & sTo,
                              ProductLocatorMethod method, int msTimeOut)
 {
     // Wait for the file to appear
-    if (msTimeOut != 0) {
-        // If timeout is > 0, wait unti timeout is completed
-        if (msTimeOut < 0) {
-            // If timeout < 0, wait forever until stat is successful
-            // (in fact, set a very large value for timeout, say 1 minute)
-            msTimeOut = 3000;
-        }
-        struct stat buffer;
-        struct timespec tsp1, tsp2;
-        long elapsed = 0;
-        (void)clock_gettime(CLOCK_REALTIME_COARSE, &tsp1);
-        while ((stat(sFrom.c_str(), &buffer) != 0) || (elapsed > msTimeOut)) {
-            (void)clock_gettime(CLOCK_REALTIME_COARSE, &tsp2);
-            elapsed = ((tsp2.tv_sec - tsp1.tv_sec) * 1000 +
-                       (tsp2.tv_nsec - tsp1.tv_nsec) / 1000000);
-        }
-        if (elapsed > msTimeOut) {
-            //TRC("ERROR: Timeout of " + std::to_string(msTimeOut) +
-            //              "ms before successful stat:\t" +
-            //              sFrom + std::string(" => ") + sTo);
-            return -1;
-        }
+    if ((msTimeOut != 0) && (! waitForFile(sFrom, msTimeOut))) {
+        TRC("ERROR: Timeout of " << msTimeOut << "ms waiting for "
+            << sFrom << " => " << sTo);
+        errno = ETIMEDOUT;
+        return -1;
     }
 
     int retVal = 0;
@@ -202,18 +194,20 @@ int ProductLocator::relocate(std::string & sFrom, std::string & sTo,
         TRC("MOVE: Moving file from " << sFrom << " to " << sTo
             << "   retVal=" << retVal);
         if (retVal != 0) {
-            TRC("MOVE: errno=" << errno << "  (EXDEV:" << EXDEV
+            int err = errno;
+            TRC("MOVE: errno=" << err << "  (EXDEV:" << EXDEV
                 << ",EEXIST:" << EEXIST << ")");
-            if (errno = EXDEV) {
+            if (err == EXDEV) {
                 // Error due to move between different logical devices
                 // Try copy & remove
-                if ((retVal = FileTools::copyfile(sFrom, sTo)) == 0) {
+                if ((retVal = CopyEngine::copy(sFrom, sTo)) == 0) {
                     (void)unlink(sFrom.c_str());
                 }
-            } else if (errno = EEXIST) {
+            } else if (err == EEXIST) {
                 // File with same name is already at target location
                 // Simply remove src.
                 (void)unlink(sFrom.c_str());
+                retVal = 0;
             }
         } else {
             struct stat buffer;
@@ -223,7 +217,7 @@ int ProductLocator::relocate(std::string & sFrom, std::string & sTo,
         }
         break;
     case COPY:
-        retVal = FileTools::copyfile(sFrom, sTo);
+        retVal = CopyEngine::copy(sFrom, sTo);
         TRC("COPY: Copying file from " << sFrom << " to " << sTo);
         break;
     case COPY_TO_REMOTE:
@@ -236,15 +230,97 @@ int ProductLocator::relocate(std::string & sFrom, std::string & sTo,
         break;
     }
 
+    // The error is left in errno, for the caller to decide what to do
     if (retVal != 0) {
-        perror(("ERROR (" + std::to_string(retVal) + "/" + std::to_string(errno) +
-                ") relocating product:\n\t" +
-                sFrom + std::string(" => ") + sTo).c_str());
-        abort();
+        int err = errno;
+        static Logger logger(Log::getLogger("prodloc"));
+        logger.error("Error (%d/%d: %s) relocating product %s => %s",
+                     retVal, err, strerror(err), sFrom.c_str(), sTo.c_str());
+        errno = err;
     }
     return retVal;
 }
 
+//----------------------------------------------------------------------
+// Method: relocateAsync
+// Relocates the product in a separate thread, so that the caller is
+// not blocked while waiting for it to appear
+//----------------------------------------------------------------------
+std::future<int> ProductLocator::relocateAsync(std::string sFrom, std::string sTo,
+                                               ProductLocatorMethod method,
+                                               int msTimeOut)
+{
+    return std::async(std::launch::async,
+                      [sFrom, sTo, method, msTimeOut]() mutable {
+                          return relocate(sFrom, sTo, method, msTimeOut); });
+}
+
+//----------------------------------------------------------------------
+// Method: waitForFile
+// Waits until the file exists, or the timeout (in ms) expires, watching
+// its folder for new entries.  If the folder cannot be watched, the
+// file is looked for periodically
+//----------------------------------------------------------------------
+bool ProductLocator::waitForFile(const std::string & fileName, int msTimeOut)
+{
+    using namespace std::chrono;
+    struct stat buffer;
+    if (stat(fileName.c_str(), &buffer) == 0) { return true; }
+    if (msTimeOut == 0) { return false; }
+    if (msTimeOut < 0) { msTimeOut = DefaultFileWait; }
+    steady_clock::time_point deadline = (steady_clock::now() +
+                                         milliseconds(msTimeOut));
+
+    size_t pos = fileName.rfind('/');
+    std::string dir = ((pos == std::string::npos) ? std::string(".") :
+                       (pos == 0) ? std::string("/") : fileName.substr(0, pos));
+    std::string base = ((pos == std::string::npos) ?
+                        fileName : fileName.substr(pos + 1));
+
+    int fd = inotify_init1(IN_CLOEXEC);
+    int wd = -1;
+    if (fd >= 0) {
+        wd = inotify_add_watch(fd, dir.c_str(),
+                               IN_CREATE | IN_MOVED_TO | IN_CLOSE_WRITE);
+    }
+
+    // The file may have appeared before the watch was set
+    bool found = (stat(fileName.c_str(), &buffer) == 0);
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+    while (! found) {
+        int remaining = (int)(duration_cast<milliseconds>(deadline -
+                                                          steady_clock::now()).count());
+        if (remaining <= 0) { break; }
+
+        if (wd < 0) {
+            std::this_thread::sleep_for(milliseconds(std::min(remaining, 50)));
+            found = (stat(fileName.c_str(), &buffer) == 0);
+            continue;
+        }
+
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int n = poll(&pfd, 1, remaining);
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            break;
+        }
+        if (n == 0) { break; }
+
+        ssize_t len = read(fd, buf, sizeof(buf));
+        if (len <= 0) { continue; }
+        for (char * p = buf; p < buf + len;) {
+            struct inotify_event * ev = (struct inotify_event *)(p);
+            if ((ev->len > 0) && (base == ev->name)) { found = true; }
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+        found = found && (stat(fileName.c_str(), &buffer) == 0);
+    }
+
+    if (fd >= 0) { close(fd); }
+    return found;
+}
+
 //----------------------------------------------------------------------
 // Method: setRemote
 //----------------------------------------------------------------------
@@ -50,6 +50,7 @@
 //   - iostream
 //------------------------------------------------------------
 #include <iostream>
+#include <future>
 
 //------------------------------------------------------------
 // Topic: External packages
@@ -115,10 +116,27 @@ public:
     
     //----------------------------------------------------------------------
     // Method: relocate
+    // Returns 0 on success, or non-zero with the error left in errno
     //----------------------------------------------------------------------
     static int relocate(std::string & sFrom, std::string & sTo,
                         ProductLocatorMethod method = LINK, int msTimeOut = 0);
 
+    //----------------------------------------------------------------------
+    // Method: relocateAsync
+    // Relocates the product in a separate thread, so that the caller is
+    // not blocked while waiting for it to appear
+    //----------------------------------------------------------------------
+    static std::future<int> relocateAsync(std::string sFrom, std::string sTo,
+                                          ProductLocatorMethod method = LINK,
+                                          int msTimeOut = 0);
+
+    //----------------------------------------------------------------------
+    // Method: waitForFile
+    // Waits until the file exists, or the timeout (in ms) expires.  A
+    // negative timeout means the default one
+    //----------------------------------------------------------------------
+    static bool waitForFile(const std::string & fileName, int msTimeOut);
+
     //----------------------------------------------------------------------
     // Method: setRemote
     //----------------------------------------------------------------------
@@ -140,6 +158,8 @@ private:
     static std::string master_address;
     static std::string remote_address;
     static bool isRemote;
+
+    static const int DefaultFileWait;
 };
 
 #endif // PRODUCTLOCATOR_H
@@ -0,0 +1,302 @@
+/******************************************************************************
+ * File:    relocator.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.Relocator
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement Relocator class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#include "relocator.h"
+#include "copyeng.h"
+
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <algorithm>
+
+#include "json.hpp"
+using json = nlohmann::json;
+
+//----------------------------------------------------------------------
+// Errors with their names, as used in the configuration
+//----------------------------------------------------------------------
+static const std::map<std::string, int> ErrorCodes = {
+    {"EACCES", EACCES}, {"EAGAIN", EAGAIN}, {"EBUSY", EBUSY},
+    {"EEXIST", EEXIST}, {"EINTR", EINTR}, {"EIO", EIO},
+    {"EMFILE", EMFILE}, {"ENFILE", ENFILE}, {"ENOENT", ENOENT},
+    {"ENOSPC", ENOSPC}, {"EPERM", EPERM}, {"EROFS", EROFS},
+    {"ESTALE", ESTALE}, {"ETIMEDOUT", ETIMEDOUT}, {"EXDEV", EXDEV},
+};
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+Relocator::Relocator(std::string _deadLetter, int _numOfWorkers)
+    : deadLetter(_deadLetter), numOfWorkers(std::max(_numOfWorkers, 1)),
+      inFlight(0), quit(false),
+      logger(Log::getLogger("reloc"))
+{
+    // Transient errors, mostly from network filesystems
+    setRetryPolicy(EAGAIN,    5,  100);
+    setRetryPolicy(EBUSY,     5,  200);
+    setRetryPolicy(EINTR,     5,   10);
+    setRetryPolicy(EMFILE,    5,  500);
+    setRetryPolicy(ENFILE,    5,  500);
+    setRetryPolicy(ESTALE,    5,  500);
+    setRetryPolicy(ETIMEDOUT, 5, 1000);
+    setRetryPolicy(EIO,       3, 1000);
+    setRetryPolicy(ENOSPC,    3, 5000);
+}
+
+//----------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------
+Relocator::~Relocator()
+{
+    stop();
+}
+
+//----------------------------------------------------------------------
+// Method: setRetryPolicy
+// Number of retries for an error, and delay before the first one
+// (doubled for each of the next ones).  No retries means that the
+// relocation fails at once
+//----------------------------------------------------------------------
+void Relocator::setRetryPolicy(int err, int maxRetries, int delayMs)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (maxRetries < 1) {
+        retryPolicies.erase(err);
+    } else {
+        retryPolicies[err] = RetryPolicy {maxRetries, std::max(delayMs, 0)};
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: errorCode
+// Returns the errno value with the given name, or 0 if unknown
+//----------------------------------------------------------------------
+int Relocator::errorCode(const std::string & name)
+{
+    auto it = ErrorCodes.find(name);
+    return (it == ErrorCodes.end()) ? 0 : it->second;
+}
+
+//----------------------------------------------------------------------
+// Method: start
+//----------------------------------------------------------------------
+bool Relocator::start()
+{
+    if ((mkdir(deadLetter.c_str(), 0755) != 0) && (errno != EEXIST)) {
+        logger.error("Cannot create dead-letter folder %s: %s",
+                     deadLetter.c_str(), strerror(errno));
+        return false;
+    }
+    for (int i = 0; i < numOfWorkers; ++i) {
+        workers.emplace_back(&Relocator::run, this);
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: stop
+// Stops the workers once the relocations due are done.  Those
+// waiting for a retry are cancelled, leaving their products in place
+//----------------------------------------------------------------------
+void Relocator::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (quit) { return; }
+        quit = true;
+    }
+    cv.notify_all();
+    for (auto & w: workers) { w.join(); }
+    workers.clear();
+
+    std::multimap<TimePoint, Relocation> cancelled;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        cancelled.swap(queue);
+    }
+    for (auto & kv: cancelled) {
+        logger.warn("Relocation of %s to %s cancelled",
+                    kv.second.from.c_str(), kv.second.to.c_str());
+        if (kv.second.done) { kv.second.done(ECANCELED); }
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: submit
+//----------------------------------------------------------------------
+void Relocator::submit(std::string from, std::string to,
+                       ProductLocator::ProductLocatorMethod method,
+                       Callback done, int msTimeOut)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.emplace(std::chrono::steady_clock::now(),
+                      Relocation {from, to, method, msTimeOut, done, 0});
+    }
+    cv.notify_one();
+}
+
+//----------------------------------------------------------------------
+// Method: pending
+// Returns the number of relocations not yet completed
+//----------------------------------------------------------------------
+size_t Relocator::pending()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return queue.size() + inFlight;
+}
+
+//----------------------------------------------------------------------
+// Method: run
+// Takes the relocations due, in order, and queues again those to be
+// retried
+//----------------------------------------------------------------------
+void Relocator::run()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;) {
+        auto now = std::chrono::steady_clock::now();
+        bool due = ((! queue.empty()) && (queue.begin()->first <= now));
+        if (! due) {
+            if (quit) { break; }
+            if (queue.empty()) {
+                cv.wait(lock);
+            } else {
+                cv.wait_until(lock, queue.begin()->first);
+            }
+            continue;
+        }
+
+        Relocation r = std::move(queue.begin()->second);
+        queue.erase(queue.begin());
+        inFlight++;
+        lock.unlock();
+
+        int delayMs = 0;
+        bool retry = process(r, delayMs);
+
+        lock.lock();
+        inFlight--;
+        if (retry) {
+            queue.emplace(std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(delayMs), std::move(r));
+            cv.notify_one();
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: process
+// Relocates the product.  Returns true if it is to be tried again
+// after the given delay, or calls its callback otherwise
+//----------------------------------------------------------------------
+bool Relocator::process(Relocation & r, int & delayMs)
+{
+    errno = 0;
+    int err = 0;
+    if (ProductLocator::relocate(r.from, r.to, r.method, r.msTimeOut) != 0) {
+        err = (errno != 0) ? errno : EIO;
+    }
+
+    if (err != 0) {
+        RetryPolicy policy {0, 0};
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = retryPolicies.find(err);
+            if (it != retryPolicies.end()) { policy = it->second; }
+        }
+        if (r.attempt < policy.maxRetries) {
+            delayMs = policy.delayMs << std::min(r.attempt, 16);
+            r.attempt++;
+            logger.warn("Relocation of %s failed (%s), retry %d in %d ms",
+                        r.from.c_str(), strerror(err), r.attempt, delayMs);
+            return true;
+        }
+        toDeadLetter(r, err);
+    }
+
+    if (r.done) { r.done(err); }
+    return false;
+}
+
+//----------------------------------------------------------------------
+// Method: toDeadLetter
+// Moves the product of a failed relocation to the dead-letter folder,
+// together with a description of the failure
+//----------------------------------------------------------------------
+void Relocator::toDeadLetter(Relocation & r, int err)
+{
+    size_t pos = r.from.rfind('/');
+    std::string base = ((pos == std::string::npos) ?
+                        r.from : r.from.substr(pos + 1));
+    std::string target = deadLetter + "/" + base;
+    struct stat st;
+    for (int i = 1; stat(target.c_str(), &st) == 0; ++i) {
+        target = deadLetter + "/" + base + "." + std::to_string(i);
+    }
+
+    logger.error("Relocation of %s to %s failed after %d attempts (%s), "
+                 "moved to %s", r.from.c_str(), r.to.c_str(), r.attempt + 1,
+                 strerror(err), target.c_str());
+
+    bool moved = false;
+    if (stat(r.from.c_str(), &st) == 0) {
+        moved = (rename(r.from.c_str(), target.c_str()) == 0);
+        if ((! moved) && (errno == EXDEV) &&
+            (CopyEngine::copy(r.from, target) == 0)) {
+            (void)unlink(r.from.c_str());
+            moved = true;
+        }
+        if (! moved) {
+            logger.error("Cannot move %s to dead-letter folder: %s",
+                         r.from.c_str(), strerror(errno));
+        }
+    }
+
+    json note = {{"from", r.from}, {"to", r.to}, {"method", (int)(r.method)},
+                 {"errno", err}, {"error", strerror(err)},
+                 {"attempts", r.attempt + 1}, {"moved", moved}};
+    std::ofstream fnote(target + ".err.json");
+    fnote << note.dump(4) << '\n';
+}
@@ -0,0 +1,188 @@
+/******************************************************************************
+ * File:    relocator.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.Relocator
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare Relocator class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#ifndef RELOCATOR_H
+#define RELOCATOR_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//   - map
+//   - vector
+//   - thread
+//   - mutex
+//   - condition_variable
+//   - functional
+//------------------------------------------------------------
+#include <string>
+#include <map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+#include "log.h"
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+#include "prodloc.h"
+
+//==========================================================================
+// Class: Relocator
+// Relocates products asynchronously, on a small pool of workers.  The
+// relocations that fail with a transient error are tried again later,
+// following the retry policy of the error.  Those that finally fail
+// leave their product, with a note of the error, in the dead-letter
+// folder.  The callback of the relocation is called from the worker,
+// with 0 or the last error
+//==========================================================================
+class Relocator {
+
+public:
+    typedef std::function<void(int)> Callback;
+
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    Relocator(std::string _deadLetter, int _numOfWorkers = 2);
+
+    //----------------------------------------------------------------------
+    // Destructor
+    //----------------------------------------------------------------------
+    virtual ~Relocator();
+
+    //----------------------------------------------------------------------
+    // Method: setRetryPolicy
+    // Number of retries for an error, and delay before the first one
+    // (doubled for each of the next ones)
+    //----------------------------------------------------------------------
+    void setRetryPolicy(int err, int maxRetries, int delayMs);
+
+    //----------------------------------------------------------------------
+    // Method: errorCode
+    // Returns the errno value with the given name, or 0 if unknown
+    //----------------------------------------------------------------------
+    static int errorCode(const std::string & name);
+
+    //----------------------------------------------------------------------
+    // Method: start
+    //----------------------------------------------------------------------
+    bool start();
+
+    //----------------------------------------------------------------------
+    // Method: stop
+    // Stops the workers once the relocations due are done.  Those
+    // waiting for a retry are cancelled
+    //----------------------------------------------------------------------
+    void stop();
+
+    //----------------------------------------------------------------------
+    // Method: submit
+    //----------------------------------------------------------------------
+    void submit(std::string from, std::string to,
+                ProductLocator::ProductLocatorMethod method,
+                Callback done, int msTimeOut = 0);
+
+    //----------------------------------------------------------------------
+    // Method: pending
+    // Returns the number of relocations not yet completed
+    //----------------------------------------------------------------------
+    size_t pending();
+
+private:
+    struct Relocation {
+        std::string from;
+        std::string to;
+        ProductLocator::ProductLocatorMethod method;
+        int         msTimeOut;
+        Callback    done;
+        int         attempt;
+    };
+
+    struct RetryPolicy {
+        int maxRetries;
+        int delayMs;
+    };
+
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    //----------------------------------------------------------------------
+    // Method: run
+    //----------------------------------------------------------------------
+    void run();
+
+    //----------------------------------------------------------------------
+    // Method: process
+    //----------------------------------------------------------------------
+    bool process(Relocation & r, int & delayMs);
+
+    //----------------------------------------------------------------------
+    // Method: toDeadLetter
+    //----------------------------------------------------------------------
+    void toDeadLetter(Relocation & r, int err);
+
+private:
+    std::string deadLetter;
+    int numOfWorkers;
+
+    std::map<int, RetryPolicy> retryPolicies;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::multimap<TimePoint, Relocation> queue;
+    size_t inFlight;
+    bool quit;
+    std::vector<std::thread> workers;
+
+    Logger logger;
+};
+
+#endif // RELOCATOR_H
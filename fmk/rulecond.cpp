@@ -0,0 +1,514 @@
+/******************************************************************************
+ * File:    rulecond.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.RuleCondition
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement RuleCondition class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#include "rulecond.h"
+#include "str.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+RuleCondition::RuleCondition()
+    : alwaysTrue(true), maxDepth(0)
+{
+}
+
+//----------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------
+RuleCondition::~RuleCondition()
+{
+}
+
+//----------------------------------------------------------------------
+// Method: Value::isTrue
+//----------------------------------------------------------------------
+bool RuleCondition::Value::isTrue() const
+{
+    if (! isStr) { return num != 0.; }
+    return !(txt.empty() || (txt == "0") || (txt == "F") || (txt == "false"));
+}
+
+//----------------------------------------------------------------------
+// Method: Value::toNum
+// Gets numeric value, if the value is a number or a numeric string
+//----------------------------------------------------------------------
+bool RuleCondition::Value::toNum(double & x) const
+{
+    if (! isStr) { x = num; return true; }
+    if (txt.empty()) { return false; }
+    char * end;
+    x = strtod(txt.c_str(), &end);
+    while ((*end != 0) && isspace(*end)) { ++end; }
+    return (*end == 0);
+}
+
+//----------------------------------------------------------------------
+// Method: precedence
+//----------------------------------------------------------------------
+int RuleCondition::precedence(OpCode op)
+{
+    switch (op) {
+    case OP_OR:  return 1;
+    case OP_AND: return 2;
+    case OP_EQ:
+    case OP_NE:  return 3;
+    case OP_LT:
+    case OP_LE:
+    case OP_GT:
+    case OP_GE:  return 4;
+    case OP_ADD:
+    case OP_SUB: return 5;
+    case OP_MUL:
+    case OP_DIV:
+    case OP_MOD: return 6;
+    case OP_NOT:
+    case OP_NEG: return 7;
+    default:     return 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: fail
+//----------------------------------------------------------------------
+bool RuleCondition::fail(string msg, size_t pos)
+{
+    errMsg = msg + " at position " + std::to_string(pos) +
+        " of condition '" + source + "'";
+    code.clear();
+    alwaysTrue = false;
+    return false;
+}
+
+//----------------------------------------------------------------------
+// Method: emit
+// Appends an instruction to the program, keeping track of the
+// evaluation stack depth
+//----------------------------------------------------------------------
+bool RuleCondition::emit(OpCode op, int arg, int & depth)
+{
+    int needed = ((op == OP_CONST) || (op == OP_VAR)) ? 0 :
+        (((op == OP_NOT) || (op == OP_NEG)) ? 1 : 2);
+    if (depth < needed) { return false; }
+    depth += (needed == 0) ? 1 : (1 - needed);
+    if (depth > maxDepth) { maxDepth = depth; }
+    code.push_back(Instr({op, arg}));
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: compile
+// Translates the infix expression into a postfix program (shunting-yard)
+//----------------------------------------------------------------------
+bool RuleCondition::compile(string expr)
+{
+    source = expr;
+    errMsg.clear();
+    code.clear();
+    consts.clear();
+    vars.clear();
+    maxDepth = 0;
+
+    vector<OpCode> ops;  // OP_NONE is used as the open parenthesis mark
+    bool expectOperand = true;
+    int depth = 0;
+    size_t n = expr.length();
+    size_t i = 0;
+
+    auto reduce = [&](int prec, bool rightAssoc) {
+        while (!ops.empty() && (ops.back() != OP_NONE)) {
+            int p = precedence(ops.back());
+            if ((p < prec) || (rightAssoc && (p == prec))) { break; }
+            if (! emit(ops.back(), 0, depth)) { return false; }
+            ops.pop_back();
+        }
+        return true;
+    };
+
+    while (i < n) {
+        char c = expr[i];
+        size_t start = i;
+        if (isspace(c)) { ++i; continue; }
+
+        if (isdigit(c) || ((c == '.') && (i + 1 < n) && isdigit(expr[i + 1]))) {
+            if (! expectOperand) { return fail("Unexpected number", start); }
+            char * end;
+            double x = strtod(expr.c_str() + i, &end);
+            i = end - expr.c_str();
+            consts.push_back(Value(x));
+            emit(OP_CONST, consts.size() - 1, depth);
+            expectOperand = false;
+            continue;
+        }
+
+        if ((c == '\'') || (c == '"')) {
+            if (! expectOperand) { return fail("Unexpected string", start); }
+            size_t j = expr.find(c, i + 1);
+            if (j == string::npos) { return fail("Unterminated string", start); }
+            consts.push_back(Value(expr.substr(i + 1, j - i - 1)));
+            emit(OP_CONST, consts.size() - 1, depth);
+            i = j + 1;
+            expectOperand = false;
+            continue;
+        }
+
+        if (isalpha(c) || (c == '_')) {
+            while ((i < n) && (isalnum(expr[i]) || (expr[i] == '_') ||
+                               (expr[i] == '.'))) { ++i; }
+            string ident = expr.substr(start, i - start);
+
+            // Keys with other characters (i.e. DATE-OBS) are quoted,
+            // in brackets: hdr['DATE-OBS']
+            vector<string> quotedKeys;
+            while ((i < n) && (expr[i] == '[')) {
+                size_t q = expr.find_first_not_of(' ', i + 1);
+                if ((q == string::npos) || ((expr[q] != '\'') && (expr[q] != '"'))) {
+                    return fail("Expected quoted key", i);
+                }
+                size_t qe = expr.find(expr[q], q + 1);
+                if (qe == string::npos) { return fail("Unterminated key", q); }
+                size_t b = expr.find_first_not_of(' ', qe + 1);
+                if ((b == string::npos) || (expr[b] != ']')) {
+                    return fail("Expected ']'", qe + 1);
+                }
+                quotedKeys.push_back(expr.substr(q + 1, qe - q - 1));
+                i = b + 1;
+            }
+            if ((! quotedKeys.empty()) && (ident.back() == '.')) {
+                return fail("Unexpected '.'", start);
+            }
+
+            OpCode op = OP_NONE;
+            if ((ident == "and") || (ident == "AND")) { op = OP_AND; }
+            else if ((ident == "or") || (ident == "OR")) { op = OP_OR; }
+            else if ((ident == "not") || (ident == "NOT")) { op = OP_NOT; }
+            if (op == OP_NOT) {
+                if (! expectOperand) { return fail("Unexpected 'not'", start); }
+                ops.push_back(op);
+                continue;
+            }
+            if (op != OP_NONE) {
+                if (expectOperand) { return fail("Missing operand", start); }
+                if (! reduce(precedence(op), false)) {
+                    return fail("Missing operand", start);
+                }
+                ops.push_back(op);
+                expectOperand = true;
+                continue;
+            }
+            if (! expectOperand) { return fail("Unexpected identifier", start); }
+            if (((ident == "true") || (ident == "false")) && quotedKeys.empty()) {
+                consts.push_back(Value(ident == "true" ? 1. : 0.));
+                emit(OP_CONST, consts.size() - 1, depth);
+            } else {
+                vector<string> path;
+                size_t k = 0, dot;
+                while ((dot = ident.find('.', k)) != string::npos) {
+                    path.push_back(ident.substr(k, dot - k));
+                    k = dot + 1;
+                }
+                path.push_back(ident.substr(k));
+                path.insert(path.end(), quotedKeys.begin(), quotedKeys.end());
+                vars.push_back(path);
+                emit(OP_VAR, vars.size() - 1, depth);
+            }
+            expectOperand = false;
+            continue;
+        }
+
+        if (c == '(') {
+            if (! expectOperand) { return fail("Unexpected '('", start); }
+            ops.push_back(OP_NONE);
+            ++i;
+            continue;
+        }
+
+        if (c == ')') {
+            if (expectOperand) { return fail("Missing operand", start); }
+            if (! reduce(0, false)) { return fail("Missing operand", start); }
+            if (ops.empty()) { return fail("Unbalanced parenthesis", start); }
+            ops.pop_back();
+            ++i;
+            continue;
+        }
+
+        // Operators
+        string two = expr.substr(i, 2);
+        OpCode op = OP_NONE;
+        size_t len = 2;
+        if      (two == "&&") { op = OP_AND; }
+        else if (two == "||") { op = OP_OR; }
+        else if (two == "==") { op = OP_EQ; }
+        else if (two == "!=") { op = OP_NE; }
+        else if (two == "<=") { op = OP_LE; }
+        else if (two == ">=") { op = OP_GE; }
+        else {
+            len = 1;
+            switch (c) {
+            case '<': op = OP_LT;  break;
+            case '>': op = OP_GT;  break;
+            case '=': op = OP_EQ;  break;
+            case '+': op = OP_ADD; break;
+            case '-': op = OP_SUB; break;
+            case '*': op = OP_MUL; break;
+            case '/': op = OP_DIV; break;
+            case '%': op = OP_MOD; break;
+            case '!': op = OP_NOT; break;
+            default:
+                return fail(string("Unknown symbol '") + c + "'", start);
+            }
+        }
+        i += len;
+
+        if (expectOperand) {
+            // Only unary operators are allowed here
+            if (op == OP_SUB) { op = OP_NEG; }
+            else if (op == OP_ADD) { continue; }
+            else if (op != OP_NOT) { return fail("Missing operand", start); }
+            ops.push_back(op);
+            continue;
+        }
+        if (op == OP_NOT) { return fail("Unexpected '!'", start); }
+
+        if (! reduce(precedence(op), false)) {
+            return fail("Missing operand", start);
+        }
+        ops.push_back(op);
+        expectOperand = true;
+    }
+
+    if (expectOperand && !(code.empty() && ops.empty())) {
+        return fail("Missing operand", n);
+    }
+    while (!ops.empty()) {
+        if (ops.back() == OP_NONE) { return fail("Unbalanced parenthesis", n); }
+        if (! emit(ops.back(), 0, depth)) { return fail("Missing operand", n); }
+        ops.pop_back();
+    }
+
+    // Empty conditions are taken as "1" (always true)
+    if (code.empty()) {
+        alwaysTrue = true;
+        return true;
+    }
+    if (depth != 1) { return fail("Missing operator", n); }
+
+    alwaysTrue = ((code.size() == 1) && (code.at(0).op == OP_CONST) &&
+                  consts.at(code.at(0).arg).isTrue());
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: lookupHeader
+// Retrieves the value of a FITS keyword, either from a dictionary or
+// from the header card images (KEYWORD = value / comment)
+//----------------------------------------------------------------------
+RuleCondition::Value RuleCondition::lookupHeader(string const & key,
+                                                 ProductMeta & meta) const
+{
+    auto it = meta.find("meta");
+    if (it == meta.end()) { return Value(string("")); }
+
+    if (it->is_object()) {
+        auto kt = it->find(key);
+        if (kt == it->end()) { return Value(string("")); }
+        if (kt->is_number()) { return Value(kt->get<double>()); }
+        if (kt->is_string()) { return Value(kt->get<string>()); }
+        return Value(kt->dump());
+    }
+    if (! it->is_string()) { return Value(string("")); }
+
+    // The header is either a sequence of lines, or the raw 80-column
+    // cards, that are not separated at all
+    static const size_t CardLength = 80;
+    string const & hdr = it->get_ref<string const &>();
+    bool rawCards = (hdr.find('\n') == string::npos);
+    size_t pos = 0;
+    while ((pos = hdr.find(key, pos)) != string::npos) {
+        size_t cardStart = pos;
+        size_t k = pos + key.length();
+        bool startsCard = (rawCards ? ((pos % CardLength) == 0) :
+                           ((pos == 0) || isspace(hdr[pos - 1])));
+        pos = k;
+        if (! startsCard) { continue; }
+
+        size_t cardEnd = (rawCards ? (cardStart + CardLength) :
+                          hdr.find('\n', cardStart));
+        cardEnd = std::min(cardEnd, hdr.length());
+        while ((k < cardEnd) && (hdr[k] == ' ')) { ++k; }
+        if ((k >= cardEnd) || (hdr[k] != '=')) { continue; }
+        ++k;
+        while ((k < cardEnd) && (hdr[k] == ' ')) { ++k; }
+
+        // String values are quoted, and may contain slashes; other
+        // values end at the comment, if any
+        string v;
+        if ((k < cardEnd) && (hdr[k] == '\'')) {
+            size_t e = hdr.find('\'', k + 1);
+            if ((e == string::npos) || (e > cardEnd)) { e = cardEnd; }
+            v = hdr.substr(k + 1, e - k - 1);
+        } else {
+            size_t e = hdr.find('/', k);
+            if ((e == string::npos) || (e > cardEnd)) { e = cardEnd; }
+            v = hdr.substr(k, e - k);
+        }
+        size_t b = v.find_first_not_of(' ');
+        size_t l = v.find_last_not_of(' ');
+        v = (b == string::npos) ? string("") : v.substr(b, l - b + 1);
+        return Value(v);
+    }
+    return Value(string(""));
+}
+
+//----------------------------------------------------------------------
+// Method: lookup
+//----------------------------------------------------------------------
+RuleCondition::Value RuleCondition::lookup(int slot, ProductMeta & meta) const
+{
+    vector<string> const & path = vars.at(slot);
+    if ((path.size() == 2) && (path.at(0) == "hdr")) {
+        return lookupHeader(path.at(1), meta);
+    }
+
+    json * j = &meta;
+    for (auto & key: path) {
+        if (! j->is_object()) { return Value(string("")); }
+        auto it = j->find(key);
+        if (it == j->end()) { return Value(string("")); }
+        j = &(*it);
+    }
+
+    if (j->is_number())  { return Value(j->get<double>()); }
+    if (j->is_boolean()) { return Value(j->get<bool>() ? 1. : 0.); }
+    if (j->is_string())  { return Value(j->get<string>()); }
+    if (j->is_null())    { return Value(string("")); }
+    return Value(j->dump());
+}
+
+//----------------------------------------------------------------------
+// Method: compare
+// Numeric comparison if both values are numeric, text comparison
+// otherwise
+//----------------------------------------------------------------------
+int RuleCondition::compare(Value const & a, Value const & b)
+{
+    double x, y;
+    if (a.toNum(x) && b.toNum(y)) {
+        return (x < y) ? -1 : ((x > y) ? 1 : 0);
+    }
+    string sa = a.isStr ? a.txt : str::toStr<double>(a.num);
+    string sb = b.isStr ? b.txt : str::toStr<double>(b.num);
+    return sa.compare(sb);
+}
+
+//----------------------------------------------------------------------
+// Method: eval
+// Runs the compiled program on the product metadata
+//----------------------------------------------------------------------
+bool RuleCondition::eval(ProductMeta & meta) const
+{
+    if (alwaysTrue) { return true; }
+    if (code.empty()) { return false; }
+
+    vector<Value> stk;
+    stk.reserve(maxDepth);
+
+    for (auto const & ins: code) {
+        switch (ins.op) {
+        case OP_CONST:
+            stk.push_back(consts[ins.arg]);
+            continue;
+        case OP_VAR:
+            stk.push_back(lookup(ins.arg, meta));
+            continue;
+        case OP_NOT:
+            stk.back() = Value(stk.back().isTrue() ? 0. : 1.);
+            continue;
+        case OP_NEG: {
+            double x = 0.;
+            (void)stk.back().toNum(x);
+            stk.back() = Value(-x);
+            continue;
+        }
+        default:
+            break;
+        }
+
+        Value b = std::move(stk.back());
+        stk.pop_back();
+        Value & a = stk.back();
+        double x = 0., y = 0.;
+
+        switch (ins.op) {
+        case OP_AND: a = Value((a.isTrue() && b.isTrue()) ? 1. : 0.); break;
+        case OP_OR:  a = Value((a.isTrue() || b.isTrue()) ? 1. : 0.); break;
+        case OP_EQ:  a = Value(compare(a, b) == 0 ? 1. : 0.); break;
+        case OP_NE:  a = Value(compare(a, b) != 0 ? 1. : 0.); break;
+        case OP_LT:  a = Value(compare(a, b) <  0 ? 1. : 0.); break;
+        case OP_LE:  a = Value(compare(a, b) <= 0 ? 1. : 0.); break;
+        case OP_GT:  a = Value(compare(a, b) >  0 ? 1. : 0.); break;
+        case OP_GE:  a = Value(compare(a, b) >= 0 ? 1. : 0.); break;
+        case OP_ADD:
+            if (a.toNum(x) && b.toNum(y)) {
+                a = Value(x + y);
+            } else {
+                a = Value((a.isStr ? a.txt : str::toStr<double>(a.num)) +
+                          (b.isStr ? b.txt : str::toStr<double>(b.num)));
+            }
+            break;
+        default:
+            (void)a.toNum(x);
+            (void)b.toNum(y);
+            switch (ins.op) {
+            case OP_SUB: a = Value(x - y); break;
+            case OP_MUL: a = Value(x * y); break;
+            case OP_DIV: a = Value((y == 0.) ? 0. : x / y); break;
+            case OP_MOD: a = Value((y == 0.) ? 0. : fmod(x, y)); break;
+            default: break;
+            }
+        }
+    }
+
+    return stk.back().isTrue();
+}
@@ -0,0 +1,183 @@
+/******************************************************************************
+ * File:    rulecond.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.RuleCondition
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare RuleCondition class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#ifndef RULECONDITION_H
+#define RULECONDITION_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - iostream
+//------------------------------------------------------------
+#include <iostream>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+#include "types.h"
+
+//==========================================================================
+// Class: RuleCondition
+// Rule condition expression (as in the "condition" field of the
+// orchestration rules), compiled once into a postfix bytecode program
+// over ProductMeta fields.  Identifiers are dotted paths into the
+// product metadata (obs_mode, exposure, fileinfo.ext, ...), and the
+// "hdr." prefix gives access to the FITS header keywords.  Keys that
+// are not plain identifiers are given in brackets, i.e. hdr['DATE-OBS']
+//==========================================================================
+class RuleCondition {
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    RuleCondition();
+
+    //----------------------------------------------------------------------
+    // Destructor
+    //----------------------------------------------------------------------
+    virtual ~RuleCondition();
+
+    //----------------------------------------------------------------------
+    // Method: compile
+    // Translates the infix expression into the bytecode program
+    //----------------------------------------------------------------------
+    bool compile(string expr);
+
+    //----------------------------------------------------------------------
+    // Method: eval
+    // Evaluates the compiled program for a given product
+    //----------------------------------------------------------------------
+    bool eval(ProductMeta & meta) const;
+
+    //----------------------------------------------------------------------
+    // Method: isTrivial
+    // Returns true if the condition is always true (i.e. "1")
+    //----------------------------------------------------------------------
+    bool isTrivial() const { return alwaysTrue; }
+
+    //----------------------------------------------------------------------
+    // Method: error
+    //----------------------------------------------------------------------
+    string const & error() const { return errMsg; }
+
+    //----------------------------------------------------------------------
+    // Method: str
+    //----------------------------------------------------------------------
+    string const & str() const { return source; }
+
+public:
+    struct Value {
+        Value() : isStr(false), num(0.) {}
+        Value(double x) : isStr(false), num(x) {}
+        Value(string s) : isStr(true), num(0.), txt(s) {}
+        bool   isStr;
+        double num;
+        string txt;
+        bool isTrue() const;
+        bool toNum(double & x) const;
+    };
+
+private:
+    enum OpCode {
+        OP_CONST, OP_VAR,
+        OP_NOT, OP_NEG,
+        OP_MUL, OP_DIV, OP_MOD, OP_ADD, OP_SUB,
+        OP_LT, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE,
+        OP_AND, OP_OR,
+        OP_NONE
+    };
+
+    struct Instr {
+        OpCode op;
+        int    arg;
+    };
+
+    //----------------------------------------------------------------------
+    // Method: lookup
+    // Retrieves the value of a variable slot from the product metadata
+    //----------------------------------------------------------------------
+    Value lookup(int slot, ProductMeta & meta) const;
+
+    //----------------------------------------------------------------------
+    // Method: lookupHeader
+    // Retrieves the value of a FITS keyword from the product header
+    //----------------------------------------------------------------------
+    Value lookupHeader(string const & key, ProductMeta & meta) const;
+
+    //----------------------------------------------------------------------
+    // Method: compare
+    //----------------------------------------------------------------------
+    static int compare(Value const & a, Value const & b);
+
+    //----------------------------------------------------------------------
+    // Method: precedence
+    //----------------------------------------------------------------------
+    static int precedence(OpCode op);
+
+    //----------------------------------------------------------------------
+    // Method: emit
+    //----------------------------------------------------------------------
+    bool emit(OpCode op, int arg, int & depth);
+
+    //----------------------------------------------------------------------
+    // Method: fail
+    //----------------------------------------------------------------------
+    bool fail(string msg, size_t pos);
+
+private:
+    string source;
+    string errMsg;
+    bool alwaysTrue;
+
+    vector<Instr> code;
+    vector<Value> consts;
+    vector<vector<string>> vars;
+    int maxDepth;
+};
+
+#endif // RULECONDITION_H
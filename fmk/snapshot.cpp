@@ -0,0 +1,92 @@
+/******************************************************************************
+ * File:    snapshot.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.Snapshot
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement Snapshot and SnapshotPublisher classes
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#include "snapshot.h"
+
+#include <atomic>
+#include <chrono>
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+Snapshot::Snapshot(std::string && _body, unsigned long _version,
+                   const std::string & _epoch)
+    : body(std::move(_body)), version(_version),
+      etag("\"" + _epoch + "-" + std::to_string(_version) + "\"")
+{
+}
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+SnapshotPublisher::SnapshotPublisher(std::string initial)
+    : version(0)
+{
+    // The epoch prevents ETags of a previous run from matching
+    using namespace std::chrono;
+    epoch = std::to_string(duration_cast<seconds>(system_clock::now()
+                                                  .time_since_epoch()).count());
+    current = std::make_shared<const Snapshot>(std::move(initial),
+                                               version, epoch);
+}
+
+//----------------------------------------------------------------------
+// Method: publish
+// Publishes the new content, returns false if it did not change
+//----------------------------------------------------------------------
+bool SnapshotPublisher::publish(std::string && body)
+{
+    // Only the publishing thread replaces the pointer, so it can read
+    // it without synchronization
+    if (current->body == body) { return false; }
+    SnapshotPtr snap = std::make_shared<const Snapshot>(std::move(body),
+                                                        ++version, epoch);
+    std::atomic_store(&current, snap);
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: get
+// Returns the last snapshot published
+//----------------------------------------------------------------------
+SnapshotPtr SnapshotPublisher::get() const
+{
+    return std::atomic_load(&current);
+}
@@ -0,0 +1,118 @@
+/******************************************************************************
+ * File:    snapshot.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.Snapshot
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare Snapshot and SnapshotPublisher classes
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//   - memory
+//------------------------------------------------------------
+#include <string>
+#include <memory>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+
+//==========================================================================
+// Class: Snapshot
+// Immutable, already serialized version of a status structure
+//==========================================================================
+class Snapshot {
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    Snapshot(std::string && _body, unsigned long _version,
+             const std::string & _epoch);
+
+public:
+    const std::string   body;
+    const unsigned long version;
+    const std::string   etag;
+};
+
+typedef std::shared_ptr<const Snapshot> SnapshotPtr;
+
+//==========================================================================
+// Class: SnapshotPublisher
+// Publishes new snapshots of a structure from the thread that owns it,
+// so that other threads (i.e. HTTP handlers) can get the last one
+// without touching the structure.  A new version is only created when
+// the serialized content changes.
+//==========================================================================
+class SnapshotPublisher {
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    SnapshotPublisher(std::string initial = std::string("{}"));
+
+    //----------------------------------------------------------------------
+    // Method: publish
+    // Publishes the new content, returns false if it did not change
+    //----------------------------------------------------------------------
+    bool publish(std::string && body);
+
+    //----------------------------------------------------------------------
+    // Method: get
+    // Returns the last snapshot published
+    //----------------------------------------------------------------------
+    SnapshotPtr get() const;
+
+private:
+    SnapshotPtr   current;
+    unsigned long version;
+    std::string   epoch;
+};
+
+#endif // SNAPSHOT_H
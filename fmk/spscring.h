@@ -0,0 +1,213 @@
+/******************************************************************************
+ * File:    spscring.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.SpscRing
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare and implement SpscRing class template
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - atomic
+//   - mutex
+//   - condition_variable
+//   - chrono
+//------------------------------------------------------------
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+
+//==========================================================================
+// Class: SpscRing
+// Bounded ring buffer for exactly one producer thread and one consumer
+// thread.  Pushing and popping are lock-free; the slots are allocated
+// once, and the elements are moved in and out of them.  The mutex and
+// condition variables are only used when one of the sides has to sleep
+// (consumer on an empty ring, producer on a full one).
+//==========================================================================
+template<typename T, size_t N>
+class SpscRing {
+
+    static_assert((N >= 2) && ((N & (N - 1)) == 0),
+                  "SpscRing capacity must be a power of 2");
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    SpscRing() : head(0), tail(0), sleepers(0) {}
+
+    //----------------------------------------------------------------------
+    // Method: tryPush
+    // Appends an element, returns false if the ring is full
+    //----------------------------------------------------------------------
+    bool tryPush(T && obj) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N) { return false; }
+        slots[t & (N - 1)] = std::move(obj);
+        tail.store(t + 1, std::memory_order_seq_cst);
+        wakeUp(notEmpty);
+        return true;
+    }
+
+    //----------------------------------------------------------------------
+    // Method: push
+    // Appends an element, waiting while the ring is full
+    //----------------------------------------------------------------------
+    void push(T && obj) {
+        while (! tryPush(std::move(obj))) {
+            sleepWhile(notFull, [this]{ return full(); }, 100);
+        }
+    }
+
+    //----------------------------------------------------------------------
+    // Method: tryPop
+    // Extracts the oldest element, returns false if the ring is empty
+    //----------------------------------------------------------------------
+    bool tryPop(T & obj) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (tail.load(std::memory_order_acquire) == h) { return false; }
+        obj = std::move(slots[h & (N - 1)]);
+        head.store(h + 1, std::memory_order_seq_cst);
+        wakeUp(notFull);
+        return true;
+    }
+
+    //----------------------------------------------------------------------
+    // Method: pop
+    // Extracts the oldest element, waiting up to msTimeOut milliseconds
+    // for one to be available.  Returns false on time out
+    //----------------------------------------------------------------------
+    bool pop(T & obj, int msTimeOut) {
+        if (tryPop(obj)) { return true; }
+        sleepWhile(notEmpty, [this]{ return empty(); }, msTimeOut);
+        return tryPop(obj);
+    }
+
+    //----------------------------------------------------------------------
+    // Method: wait
+    // Waits up to msTimeOut milliseconds for an element to be available.
+    // Returns false on time out
+    //----------------------------------------------------------------------
+    bool wait(int msTimeOut) {
+        if (! empty()) { return true; }
+        sleepWhile(notEmpty, [this]{ return empty(); }, msTimeOut);
+        return ! empty();
+    }
+
+    //----------------------------------------------------------------------
+    // Method: empty
+    //----------------------------------------------------------------------
+    bool empty() const {
+        return tail.load(std::memory_order_seq_cst) ==
+            head.load(std::memory_order_seq_cst);
+    }
+
+    //----------------------------------------------------------------------
+    // Method: full
+    //----------------------------------------------------------------------
+    bool full() const {
+        return (tail.load(std::memory_order_seq_cst) -
+                head.load(std::memory_order_seq_cst)) == N;
+    }
+
+    //----------------------------------------------------------------------
+    // Method: capacity
+    //----------------------------------------------------------------------
+    size_t capacity() const { return N; }
+
+private:
+    //----------------------------------------------------------------------
+    // Method: sleepWhile
+    // Sleeps on the condition variable while the predicate holds
+    //----------------------------------------------------------------------
+    template<typename Pred>
+    void sleepWhile(std::condition_variable & cv, Pred pred, int ms) {
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait_for(lock, std::chrono::milliseconds(ms),
+                        [&pred]{ return ! pred(); });
+        }
+        sleepers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    //----------------------------------------------------------------------
+    // Method: wakeUp
+    // Notifies the other side, only if it may be sleeping
+    //----------------------------------------------------------------------
+    void wakeUp(std::condition_variable & cv) {
+        if (sleepers.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(mtx);
+            cv.notify_one();
+        }
+    }
+
+private:
+    static const size_t CacheLine = 64;
+
+    T slots[N];
+
+    // Padding keeps both indices in different cache lines (alignas is
+    // not honoured by operator new in C++11)
+    char pad0[CacheLine];
+    std::atomic<size_t> head;
+    char pad1[CacheLine - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail;
+    char pad2[CacheLine - sizeof(std::atomic<size_t>)];
+    std::atomic<int>    sleepers;
+
+    std::mutex              mtx;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+};
+
+#endif // SPSCRING_H
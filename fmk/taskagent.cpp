@@ -43,27 +43,36 @@
 #include "fnamespec.h"
 #include "filetools.h"
 #include "prodloc.h"
-#include "jsonfhdl.h"
 #include "limits.h"
 
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+
+#include <algorithm>
 
 const string TaskAgent::QPFDckImageDefault("debian");
 const string TaskAgent::QPFDckImageRunPath("/qpf/run");
 const string TaskAgent::QPFDckImageProcPath("/qlabin");
+const string TaskAgent::QPFContainerLabel("qpf.agent");
 
 //----------------------------------------------------------------------
 // Constructor
 //----------------------------------------------------------------------
 TaskAgent::TaskAgent(WorkArea _wa, string _ident,
-                     Queue<string> * _iq, Queue<string> * _oq, Queue<string> * _tq,
-                     bool _isCommander)
-    : wa(_wa), id(_ident), iq(_iq), oq(_oq), tq(_tq),
-      isCommander(_isCommander),
-      iAmQuitting(false),
-      containerId(string("")),
-      status(TASK_UNKNOWN_STATE),
+                     TaskAssignmentRing * _iq, SpectrumUpdateRing * _oq,
+                     TaskStatusUpdateRing * _tq, ContainerEventRing * _eq,
+                     ContainerCollector * _gc, OutputWatcher * _ow,
+                     OutputHandoff * _handoff, TaskClaims * _claims,
+                     bool _isCommander, AgentSettings _settings)
+    : wa(_wa), id(_ident), iq(_iq), oq(_oq), tq(_tq), eq(_eq), gc(_gc), ow(_ow),
+      handoff(_handoff), claims(_claims),
+      isCommander(_isCommander), settings(_settings),
+      iAmQuitting(false), eventsLive(false), resyncNeeded(false),
+      watching(false),
+      procCfgs(_wa.procArea, QPFDckImageProcPath),
       logger(Log::getLogger("tskag"))
 {
     init();
@@ -74,6 +83,7 @@ TaskAgent::TaskAgent(WorkArea _wa, string _ident,
 //----------------------------------------------------------------------
 TaskAgent::~TaskAgent()
 {
+    if (warmPool) { warmPool->stop(); }
 }
 
 //----------------------------------------------------------------------
@@ -83,109 +93,139 @@ TaskAgent::~TaskAgent()
 void TaskAgent::init()
 {
     // Create Container Manager
-    dckMng = std::make_shared<ContainerMng>(ContainerMng(wa));
+    dckMng = createContainerMng();
+
+    // Create the pool of warm containers, with the tasks and processors
+    // areas mounted as for each task container
+    if ((! settings.warmPool.empty()) &&
+        (settings.containerBackend != "native")) {
+        warmPool = std::make_shared<WarmContainerPool>(createContainerMng(),
+                       vector<string> {QPFContainerLabel + "=" + id},
+                       map<string, string> {{wa.tasks, QPFDckImageRunPath + ":rw"},
+                                            {wa.procArea, QPFDckImageProcPath}},
+                       settings.warmPool);
+        warmPool->start();
+    }
 
     // Initialize user variables
     std::stringstream ss;
     ss << getuid();
     uid = ss.str();
     uname = string(getenv("USER"));
+    userOpts = {"--env", "UID=" + uid, "--env", "UNAME=" + uname};
 
-    statusStr = status.str();
+    if (settings.slots.total < 1) { settings.slots.total = 1; }
+    cpuSlotInUse.assign(settings.cpuSlots.size(), false);
 }
 
 //----------------------------------------------------------------------
-// Method: getFiles
-// Get the files according to a item expresion (i.e.: in/*.fits)
+// Method: createContainerMng
+// Creates a container manager: either talking directly to the Docker
+// Engine API, running the docker command line tool, or running the
+// processors as native processes (optionally under a cgroup, whose
+// root and limits are taken from the nativeCgroup settings)
 //----------------------------------------------------------------------
-vector<string> TaskAgent::getFiles(string item)
+std::shared_ptr<DockerMng> TaskAgent::createContainerMng()
 {
-    return FileTools::filesInFolder(str::getDirName(item.c_str()),
-                                    str::getExtension(item.c_str()));
+    if (settings.containerBackend == "api") {
+        return std::make_shared<DockerApiMng>(wa, settings.dockerSocket);
+    }
+    if (settings.containerBackend == "native") {
+        map<string, string> limits(settings.nativeCgroup);
+        limits.erase("root");
+        auto it = settings.nativeCgroup.find("root");
+        return std::make_shared<NativeExecMng>(wa,
+                   (it != settings.nativeCgroup.end()) ? it->second : string(""),
+                   limits);
+    }
+    return std::make_shared<ContainerMng>(wa);
 }
 
 //----------------------------------------------------------------------
-// Method: substitute
+// Method: getFiles
+// Get the files according to a item expresion (i.e.: in/*.fits),
+// relative to the directory open as dirFd.  The process working
+// directory is not used, so several agents may do it concurrently
 //----------------------------------------------------------------------
-string TaskAgent::substitute(string value, string rule)
+vector<string> TaskAgent::getFiles(int dirFd, string item)
 {
-    size_t pos = rule.find("=>");
-    string from = rule.substr(0, pos);
-    string to = rule.substr(pos+2);
-    return str::replaceAll(value, from, to);
-}
+    vector<string> files;
+    string folder = str::getDirName(item.c_str());
+    string ext = str::getExtension(item.c_str());
+
+    int fd = openat(dirFd, folder.empty() ? "." : folder.c_str(),
+                    O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) { return files; }
+    DIR * dir = fdopendir(fd);
+    if (dir == nullptr) {
+        close(fd);
+        return files;
+    }
 
-//----------------------------------------------------------------------
-// Method: getubstitutionRules
-// Get the list of substitution rules
-//----------------------------------------------------------------------
-std::tuple< string, vector<string> > TaskAgent::getSubstitutionRules(string item)
-{
-    auto v = str::split(item.substr(1, item.length()-2), ':');
-    return std::make_tuple(v.at(0), str::split(v.at(1), ','));
+    struct dirent * ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        bool isReg = (ent->d_type == DT_REG);
+        if (ent->d_type == DT_UNKNOWN) {
+            struct stat st;
+            isReg = ((fstatat(fd, ent->d_name, &st, 0) == 0) &&
+                     S_ISREG(st.st_mode));
+        }
+        if (! isReg) { continue; }
+        string name(ent->d_name);
+        if ((! ext.empty()) && (str::getExtension(name.c_str()) != ext)) {
+            continue;
+        }
+        files.push_back(folder.empty() ? name : folder + "/" + name);
+    }
+    closedir(dir);
+
+    std::sort(files.begin(), files.end());
+    return files;
 }
 
 //----------------------------------------------------------------------
-// Method: isSubstitutionRules
-// Determine if a certain item has rules inside
+// Method: sendSpectrumToMng
+// Send message with container id. and status back to manager
 //----------------------------------------------------------------------
-bool TaskAgent::isSubstitutionRules(string item)
+void TaskAgent::sendSpectrumToMng()
 {
-    logger.debug("Subs.rule: %s", item.c_str());
-    if (item.length() < 1) { return false; }
-    return (item[0] == '{') && (item[item.length() - 1] == '}');
+    // Send information of the containers, only if it changed
+    SpectrumUpdate msgSpec;
+    if (! containerSpectrum.takeUpdate(msgSpec)) { return; }
+    // If the manager is not keeping up, it is sent again later
+    if (! oq->tryPush(std::move(msgSpec))) { containerSpectrum.setChanged(); }
 }
 
 //----------------------------------------------------------------------
-// Method: doRules
-// Class method to apply a set of rules from config file
+// Method: sendTaskStatus
+// Send a task status update to the manager.  If it is not keeping up,
+// the update is kept, in order, to be sent in the next step
 //----------------------------------------------------------------------
-vector<string> TaskAgent::doRules(string item)
+void TaskAgent::sendTaskStatus(TaskStatusUpdate && upd)
 {
-    string from_var;
-    vector<string> rules;
-    std::tie(from_var, rules) = getSubstitutionRules(item);
-
-    logger.debug("Rule: from '%s', do {%s}", from_var.c_str(),
-                 str::join(rules, "} and {").c_str());
-    string value;
-    if (from_var == "input") {
-        value = str::join(p_inputs, " ");
-    } else if (from_var == "output") {
-        value = str::join(p_outputs, " ");
-    } else if (from_var == "log") {
-        value = str::join(p_logs, " ");
-    } else {
-        value = pcfg[from_var].get<string>();
+    flushTaskStatus();
+    if ((! unsentStatus.empty()) || (! tq->tryPush(std::move(upd)))) {
+        unsentStatus.push_back(std::move(upd));
     }
-
-    for (auto & rule: rules) {
-        value = substitute(value, rule);
-    }
-
-    logger.debug("Final result: '%s'", value.c_str());
-    return str::split(value, ' ');
 }
 
 //----------------------------------------------------------------------
-// Method: sendSpectrumToMng
-// Send message with container id. and status back to manager
+// Method: flushTaskStatus
+// Send the task status updates kept in previous steps
 //----------------------------------------------------------------------
-void TaskAgent::sendSpectrumToMng()
+void TaskAgent::flushTaskStatus()
 {
-    // Send information of the container
-    string msgSpec;
-    for (auto & kv: containerSpectrum.spectrum()) {
-        msgSpec += kv.first + ":" + std::to_string(kv.second) + " ";
-    }
-    msgSpec.pop_back();
-    oq->push(string(id));
-    oq->push(std::move(msgSpec));
+    while ((! unsentStatus.empty()) &&
+           tq->tryPush(std::move(unsentStatus.front()))) {
+        unsentStatus.pop_front();
+    }
 }
 
 //----------------------------------------------------------------------
 // Method: prepareNewTask
-// Prepare environment to launch new container for new task
+// Prepare environment to launch new container for new task.  The
+// processor configuration is compiled once, so only the inputs,
+// outputs and logs of the task are to be resolved here
 //----------------------------------------------------------------------
 bool TaskAgent::prepareNewTask(string taskId, string taskFld, string proc)
 {
@@ -193,26 +233,24 @@ bool TaskAgent::prepareNewTask(string taskId, string taskFld, string proc)
     string cfgFile(taskFld + "/" + proc + ".cfg");
     logger.debug("%s: %s", id.c_str(), cfgFile.c_str());
 
-    // Read configuration
-    JsonFileHandler jFile(cfgFile);
-    if (!jFile.read()) {
+    std::shared_ptr<const ProcessorConfig> pcfg = procCfgs.get(proc, cfgFile);
+    if (! pcfg) {
         logger.fatal("Cannot open processor config. file '" + cfgFile + "'. Exiting.");
+        return false;
     }
-    pcfg = jFile.getData();
 
     // Evaluate configuration entries
-    // 1. Input file(s), outputs and log)
-    char curdir[PATH_MAX];
-    getcwd(curdir, PATH_MAX);
-    if (chdir(taskFld.c_str()) < 0) {
-        logger.error("Cannot change to task folder " + taskFld);
+    // 1. Input file(s), outputs and log), relative to the task folder
+    int taskFd = open(taskFld.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (taskFd < 0) {
+        logger.error("Cannot open task folder " + taskFld);
         return false;
     }
-    logger.debug("Moving from %s to %s", curdir, taskFld.c_str());
 
     //--- Get inputs --------------------
-    p_inputs = getFiles(pcfg["input"].get<string>());
+    p_inputs = getFiles(taskFd, pcfg->input);
     if (p_inputs.size() < 1) {
+        close(taskFd);
         logger.error("No input files provided to the processor %s", proc.c_str());
         return false;
     }
@@ -223,28 +261,24 @@ bool TaskAgent::prepareNewTask(string taskId, string taskFld, string proc)
     i_input = str::join(iv, ",");
 
     //--- Get outputs --------------------
-    string p_output = pcfg["output"].get<string>();
-    if (isSubstitutionRules(p_output)) {
-        logger.debug("Using substitution rules to obtain outputs...");
-        p_outputs = doRules(p_output);
+    if (pcfg->output.hasRules) {
+        p_outputs = pcfg->applyRules(pcfg->output, p_inputs, p_outputs, p_logs);
     } else {
-        p_outputs = getFiles(p_output);
+        p_outputs = getFiles(taskFd, pcfg->output.expr);
     }
-    p_output = str::join(p_outputs, ",");
+    string p_output = str::join(p_outputs, ",");
     logger.debug("Output: %s", p_output.c_str());
     iv.clear();
     for (auto & s: p_outputs) { iv.push_back(str::getBaseName(s)); }
     i_output = str::join(iv, ",");
 
     //--- Get logs --------------------
-    string p_log = pcfg["log"].get<string>();
-    if (isSubstitutionRules(p_log)) {
-        logger.debug("Using substitution rules to obtain logs...");
-        p_logs = doRules(p_log);
+    if (pcfg->log.hasRules) {
+        p_logs = pcfg->applyRules(pcfg->log, p_inputs, p_outputs, p_logs);
     } else {
-        p_logs = getFiles(p_log);
+        p_logs = getFiles(taskFd, pcfg->log.expr);
     }
-    p_log = str::join(p_logs, ",");
+    string p_log = str::join(p_logs, ",");
     logger.debug("Log: %s", p_log.c_str());
     iv.clear();
     for (auto & s: p_logs) { iv.push_back(str::getBaseName(s)); }
@@ -253,181 +287,290 @@ bool TaskAgent::prepareNewTask(string taskId, string taskFld, string proc)
     // Define IO section for task inspection object
     jio = {{"input", i_input}, {"output", i_output}, {"p_log", i_log}};
 
-    chdir(curdir);
-    
-    // 2. Processor subfolder name (folder under QPF_WA/bin/"
-    string p_processor = pcfg["processor"].get<string>();
-    // 3. Processor entire subfolder name
-    string p_proc_dir = wa.procArea;  // + "/" + p_processor
-    // 4. Main script to invoke processor (something like driver.py)
-    string p_script = pcfg["script"].get<string>();
-
-    // 5. Arguments
-    string p_args = pcfg["args"].get<string>();
-
-    pcfg["input"]  = p_input;
-    pcfg["output"] = p_output;
-    pcfg["log"]    = p_log;
-    //logger.debug(">>> " + pcfg.dump());
-
-    for (auto & kv: pcfg.items()) {
-        p_args = str::replaceAll(p_args, "{" + kv.key() + "}", kv.value().get<string>());
-    }
-
-    logger.debug("Arguments: %s", p_args.c_str());
+    close(taskFd);
 
-    // Prepare Docker folder mapping, just in case...
+    // 2. Docker launch variables, with the task folder mapping
     string taskFld_img = TaskAgent::QPFDckImageRunPath + "/" + taskId;
-    string p_proc_dir_img = TaskAgent::QPFDckImageProcPath;  // + "/" + processor
-
-    // Prepare Docker launch variables
-    dck_image   = pcfg["image"].get<string>();  // Processor.QPFDckImageDefault
-    dck_exe     = pcfg["exe"].get<string>(); 
-    p_args.insert(0, (p_proc_dir_img + "/" + p_processor + "/" +
-                      pcfg["script"].get<string>() + " "));
-    dck_args    = str::split(p_args, ' ');
+    dck_image   = pcfg->image;
+    dck_exe     = pcfg->exe;
+    dck_args    = pcfg->buildArgs(p_input, p_output, p_log);
     dck_workdir = taskFld_img;
-    dck_mapping = { {taskFld, taskFld_img + ":rw"},
-                    {p_proc_dir, p_proc_dir_img} };
+    dck_mapping = pcfg->mapping;
+    dck_mapping[taskFld] = taskFld_img + ":rw";
+
+    logger.debug("Arguments: %s", str::join(dck_args, " ").c_str());
 
     return true;
 }
 
 //----------------------------------------------------------------------
 // Method: launchContainer
-// Launches container on the given task folder
-//----------------------------------------------------------------------
-bool TaskAgent::launchContainer(string & contId)
+// Launches container on the given task folder.  If there is a warm
+// container for the image, the task is run in it, otherwise a new
+// container is created.  The container is labelled with the agent and
+// task ids, so that its events can be dispatched back to this agent.
+// Warm containers are moved to the CPU set of the task before binding
+//----------------------------------------------------------------------
+bool TaskAgent::launchContainer(string & taskId, string & contId, bool & warm,
+                                vector<string> & pinOpts)
 {
-    vector<string> opts {"--workdir", dck_workdir,
-            "--env", "UID=" + uid,
-            "--env", "UNAME=" + uname,
-            "--env", "WDIR=" + dck_workdir};
+    vector<string> opts {"--workdir", dck_workdir};
+    opts.insert(opts.end(), userOpts.begin(), userOpts.end());
+    opts.insert(opts.end(), {"--env", "WDIR=" + dck_workdir});
+
+    warm = false;
+    if (warmPool && warmPool->acquire(dck_image, contId)) {
+        string exe(dck_exe);
+        vector<string> args(dck_args);
+        WarmContainerPool::bindCommand(exe, args);
+        if ((! pinOpts.empty()) && (! dckMng->update(contId, pinOpts))) {
+            logger.warn("Cannot set CPU set of warm container %s",
+                        contId.c_str());
+        }
+        if (dckMng->exec(contId, opts, exe, args)) {
+            warm = true;
+            return true;
+        }
+        logger.warn("Cannot bind task %s to warm container %s",
+                    taskId.c_str(), contId.c_str());
+        dckMng->kill(contId);
+        scheduleContainerForRemoval(contId);
+    }
+
+    opts.insert(opts.end(), {"--label", QPFContainerLabel + "=" + id,
+                             "--label", "qpf.task=" + taskId});
+    opts.insert(opts.end(), pinOpts.begin(), pinOpts.end());
+
+    // Auto-removed containers leave no logs behind, so the output of
+    // the processor is captured in the task folder
+    string exe(dck_exe);
+    vector<string> args(dck_args);
+    if (settings.autoRemove) {
+        opts.push_back("--rm");
+        args.insert(args.begin(), {"-c", "\"$@\" > " + dck_workdir +
+                                   "/container.log 2>&1", "qpf", exe});
+        exe = "sh";
+    }
 
     string cmd_line;
     
     if (! dckMng->createContainer(dck_image, opts, dck_mapping,
-                                  dck_exe, dck_args,
+                                  exe, args,
                                   contId, cmd_line)) {
         logger.error("Cannot launch container as follows: ");
         logger.fatal(cmd_line);
         return false;
     }
 
-    delay(DelayAfterContainerLaunch);
     return true;
 }
 
 //----------------------------------------------------------------------
-// Method: inspectContainer
+// Method: acquireCpuSlot
+// Takes a free CPU slot for a task of the given processor, and sets the
+// container options to pin it to the CPUs of the slot (slot mode) or
+// of the NUMA nodes of the slot (node mode).  Returns the slot index,
+// or -1 if the task is not pinned
 //----------------------------------------------------------------------
-string TaskAgent::inspectContainer(string cntId, bool fullInfo, string filter)
+int TaskAgent::acquireCpuSlot(string & proc, vector<string> & pinOpts)
 {
-    // Get inspect information
-    std::stringstream info;
-    info.str(fullInfo ? "" : "'" + filter + "'");
-    if (!dckMng->getInfo(cntId, info)) {
-        logger.error("Cannot inspect container with id %s", cntId.c_str());
-    } else {
-        json jinspect = json::parse(info);
-        jinspect["IO"] = jio;
-        info.str(jinspect.dump());
+    auto it = settings.procPinning.find(proc);
+    const string & mode = ((it != settings.procPinning.end()) ?
+                           it->second : settings.defaultPinning);
+    if (mode.empty() || (mode == "none")) { return -1; }
+
+    for (size_t i = 0; i < cpuSlotInUse.size(); ++i) {
+        if (cpuSlotInUse[i]) { continue; }
+        const CpuSlot & slot = settings.cpuSlots.at(i);
+        pinOpts = {"--cpuset-cpus", (mode == "node") ? slot.nodeCpus : slot.cpus,
+                   "--cpuset-mems", slot.mems};
+        cpuSlotInUse[i] = true;
+        return (int)(i);
     }
-    return info.str();
+    logger.warn("No free CPU slot for processor %s", proc.c_str());
+    return -1;
 }
 
 //----------------------------------------------------------------------
-// Method: launchNewTask
-// Launch new task from the tasks pool (queue)
+// Method: inspectContainer
+// Returns the main inspection fields of the container, along with the
+// task status and the IO section of the task
 //----------------------------------------------------------------------
-string TaskAgent::launchNewTask()
+string TaskAgent::inspectContainer(string cntId, json & io)
 {
-    string ntaskId, ntaskFolder, nprocessor;
-    taskQueue.get(ntaskId);
-    taskQueue.get(ntaskFolder);
-    taskQueue.get(nprocessor);
-
-    if (! prepareNewTask(ntaskId, ntaskFolder, nprocessor)) {
+    json jinspect;
+    if (! dckMng->inspect(cntId, jinspect)) {
+        logger.error("Cannot inspect container with id %s", cntId.c_str());
         return string("");
     }
+    jinspect["Task_Status"] = taskStatusFromState(jinspect["State"]);
+    jinspect["IO"] = io;
+    return jinspect.dump();
+}
 
-    string contId("");
-    if (launchContainer(contId)) {
-        inspectSelection = (InspectSelection1 +
-                        (iAmQuitting ? "RUNNING" : "STOPPED") +
-                        InspectSelection2);
-
-        inspect = inspectContainer(contId, false, inspectSelection);
-        
-        status = TaskStatus(TASK_SCHEDULED);
-        statusStr = status.str();
-        
-        for (auto & s : vector<string> {"true", ntaskId, contId,
-		    inspect, "1", statusStr}) {
-            tq->push(std::move(s));
-        }
-        taskId = ntaskId;
-        taskFolder = ntaskFolder;
-        processor = nprocessor;
+//----------------------------------------------------------------------
+// Method: taskStatusFromState
+// Translates the container state into the task status
+//----------------------------------------------------------------------
+string TaskAgent::taskStatusFromState(json & state)
+{
+    string st = state.value("Status", "");
+    if (st == "running") { return "RUNNING"; }
+    if (st == "paused")  { return "PAUSED"; }
+    if (st == "created") { return "ABORTED"; }
+    if (st == "dead")    { return "STOPPED"; }
+    if (st == "exited") {
+        int code = state.value("ExitCode", -1);
+        if (code == 0) { return "FINISHED"; }
+        if ((code < 0) || (code <= 128) || (code >= 160)) { return "FAILED"; }
+        // Killed by a signal
+        return iAmQuitting ? "RUNNING" : "STOPPED";
     }
-    return contId;
+    return "UNKNOWN_STATE";
 }
 
 //----------------------------------------------------------------------
-// Method: scheduleContainerForRemoval
-// Append container to list of containers to be removed.  This is done
-// so that the removal is done some time after the container has exited.
+// Method: selectNextTask
+// Extract from the tasks queue the first one that fits in the free
+// slots (in total, and for the class of its processor)
 //----------------------------------------------------------------------
-void TaskAgent::scheduleContainerForRemoval()
+bool TaskAgent::selectNextTask(TaskAssignment & task)
 {
-    hires_time now = timeNow();
-    containersToRemove.push_back(std::make_pair(now, containerId));
-    logger.debug("Scheduling container %s for removal",
-                 containerId.c_str());
-    containerId = "";
+    if ((int)(containers.size()) >= settings.slots.total) { return false; }
+
+    for (auto it = taskQueue.begin(); it != taskQueue.end(); ++it) {
+        auto pc = settings.slots.procClass.find(it->processor);
+        if (pc != settings.slots.procClass.end()) {
+            auto lim = settings.slots.classLimit.find(pc->second);
+            if ((lim != settings.slots.classLimit.end()) &&
+                (classInUse[pc->second] >= lim->second)) { continue; }
+        }
+        task = std::move(*it);
+        taskQueue.erase(it);
+        return true;
+    }
+    return false;
 }
 
 //----------------------------------------------------------------------
-// Method: removeOldContainers
-// Remove exited containers with an age of at least tOffset seconds
+// Method: launchNewTask
+// Launch new task, and add its container to the containers table
 //----------------------------------------------------------------------
-void TaskAgent::removeOldContainers()
+string TaskAgent::launchNewTask(TaskAssignment & task)
 {
-    static const double minElapsedMsec = DelayForEndedContainerRemoval;
-    static auto  elapsed_ms =
-        [](hires_time x, hires_time ref) {
-            return duration_cast<milliseconds>(x - ref).count(); };
+    string contId("");
+    if (! prepareNewTask(task.taskId, task.taskFolder, task.processor)) {
+        reportFailedLaunch(task.taskId);
+        return contId;
+    }
 
-    vector<string> containersToRemoveNow;
+    vector<string> pinOpts;
+    int cpuSlot = acquireCpuSlot(task.processor, pinOpts);
 
-    hires_time now = timeNow();
-    for (auto & p: containersToRemove) {
-        hires_time clk = p.first;
-        if (elapsed_ms(now, clk) > minElapsedMsec) {
-            containersToRemoveNow.push_back(p.second);
+    // Outputs of streaming processors are moved as soon as they are
+    // written, while the task runs
+    if ((ow != nullptr) &&
+        (std::find(settings.streamOutputs.begin(), settings.streamOutputs.end(),
+                   task.processor) != settings.streamOutputs.end())) {
+        ow->watch(task.taskFolder);
+    }
+
+    bool warm;
+    if (! launchContainer(task.taskId, contId, warm, pinOpts)) {
+        if (cpuSlot >= 0) { cpuSlotInUse[cpuSlot] = false; }
+        if (ow != nullptr) {
+            std::set<string> handedOver;
+            ow->unwatch(task.taskFolder, handedOver);
         }
+        reportFailedLaunch(task.taskId);
+        return string("");
     }
 
-    for (auto & c: containersToRemoveNow) {
-        // remove container
-        if (dckMng->remove(c)) {
-            logger.debug("Removing container " + c);
-        } else {
-            logger.warn("Couldn't remove container " + c);
+    // A warm container is already running.  When container events are
+    // received, the container will only be inspected once it exits
+    TaskStatusEnum status = warm ? TASK_RUNNING : TASK_SCHEDULED;
+    json info;
+    if (eventsLive) {
+        info = {{"Id", contId},
+                {"State", {{"Status", warm ? "running" : "created"}}},
+                {"Task_Status", TaskStatus(status).str()}, {"IO", jio}};
+    } else {
+        string inspect = inspectContainer(contId, jio);
+        if (! inspect.empty()) { info = json::parse(inspect); }
+    }
+    string inspect = info.is_null() ? string("") : info.dump();
+
+    sendTaskStatus(TaskStatusUpdate {true, task.taskId, contId, inspect,
+                                     1, status});
+
+    auto pc = settings.slots.procClass.find(task.processor);
+    string procClass = (pc != settings.slots.procClass.end()) ? pc->second : "";
+    if (! procClass.empty()) { classInUse[procClass]++; }
+
+    auto lt = settings.procLimits.find(task.processor);
+    TaskLimits limits = ((lt != settings.procLimits.end()) ?
+                         lt->second : settings.defaultLimits);
+    hires_time now = timeNow();
+
+    string group = task.group.empty() ? task.taskId : task.group;
+    containers.emplace(contId, ContainerTask {task.taskId, task.taskFolder,
+                task.processor, group, procClass, status, jio, info, false, -1,
+                settings.autoRemove && (! warm), cpuSlot,
+                limits, now, now, 0, "", ""});
+    return contId;
+}
+
+//----------------------------------------------------------------------
+// Method: reportFailedLaunch
+// Notify the manager that a task could not be launched, so that it is
+// no longer accounted as outstanding work of this agent
+//----------------------------------------------------------------------
+void TaskAgent::reportFailedLaunch(string & ntaskId)
+{
+    logger.error("Task %s could not be launched", ntaskId.c_str());
+    sendTaskStatus(TaskStatusUpdate {true, ntaskId, "", "{}", 0, TASK_FAILED});
+}
+
+//----------------------------------------------------------------------
+// Method: scheduleContainerForRemoval
+// Pass the container to the node collector, so that it is removed some
+// time after it has exited.  Native processes are released at once
+//----------------------------------------------------------------------
+void TaskAgent::scheduleContainerForRemoval(string contId)
+{
+    if (gc == nullptr) {
+        if (! dckMng->remove(contId)) {
+            logger.warn("Couldn't remove container " + contId);
         }
+        return;
     }
+    gc->schedule(contId, DelayForEndedContainerRemoval);
+}
 
-    containersToRemove.erase(containersToRemove.begin(),
-                             containersToRemove.begin()
-                             + containersToRemoveNow.size());
+//----------------------------------------------------------------------
+// Method: exitedContainerInfo
+// Builds the final inspection information of an exited container from
+// the last known one, when the container cannot be inspected
+//----------------------------------------------------------------------
+string TaskAgent::exitedContainerInfo(const string & contId, json & info,
+                                      int exitCode)
+{
+    info["Id"] = contId;
+    info["State"] = {{"Status", "exited"}, {"Running", false},
+                     {"ExitCode", exitCode}};
+    info["Task_Status"] = taskStatusFromState(info["State"]);
+    return info.dump();
 }
 
 //----------------------------------------------------------------------
 // Method: prepareOutputs
 // Prepare outputs, placing them in the outputs folder or in the remote
-// outputs folder to be sent to the commander host
+// outputs folder to be sent to the commander host.  The outputs are
+// handed over directly to the main loop, if possible, skipping those
+// already handed over while the task was running
 //----------------------------------------------------------------------
-void TaskAgent::prepareOutputs()
+void TaskAgent::prepareOutputs(string & taskFolder,
+                               std::set<string> & handedOver)
 {
     static FileNameSpec fns;
 
@@ -453,79 +596,338 @@ void TaskAgent::prepareOutputs()
         }
     }
 
-    // Move, instead, the output files to the inbox, so they are checked
-    // if they trigger a new rule
+    // Hand over, instead, the output files to the main loop (or move
+    // them to the inbox), so they are checked if they trigger a new rule
     for (auto & f: outFiles) {
+        if (handedOver.count(f) > 0) { continue; }
         if (! fns.parse(f, meta, b)) {
             logger.error("Cannot parse file name for product %s", f.c_str());
             continue;
         }
+        if (handoff != nullptr) {
+            handoff->push(meta, b);
+            continue;
+        }
         if (! ProductLocator::toLocalInbox(meta, wa)) {
             logger.error("Cannot move %s to local inbox folder", f.c_str());
         }
     }
 }
 
+//----------------------------------------------------------------------
+// Method: processContainerEvents
+// Apply the container events received from the Docker events monitor.
+// Starts are reported right away, while exits are marked so that the
+// container is inspected (only then) for its final state
+//----------------------------------------------------------------------
+void TaskAgent::processContainerEvents()
+{
+    if (eq == nullptr) { return; }
+
+    // A full ring means the monitor may have dropped events meanwhile
+    if (eq->full()) { resyncNeeded = true; }
+
+    ContainerEvent ev;
+    while (eq->tryPop(ev)) {
+        if (ev.action == "connected") {
+            // Exits may have been missed while disconnected
+            eventsLive = true;
+            resyncNeeded = true;
+            continue;
+        } else if (ev.action == "disconnected") {
+            eventsLive = false;
+            continue;
+        }
+
+        auto it = containers.find(ev.contId);
+        if (it == containers.end()) { continue; }
+        ContainerTask & ct = it->second;
+
+        if (ev.action == "start") {
+            if (ct.status != TASK_SCHEDULED) { continue; }
+            ct.status = TASK_RUNNING;
+            ct.info["State"]["Status"] = "running";
+            ct.info["Task_Status"] = "RUNNING";
+            sendTaskStatus(TaskStatusUpdate {false, ct.taskId, ev.contId,
+                                             ct.info.dump(), 1, ct.status});
+            containerSpectrum.append(ev.contId, ct.status);
+        } else if (ev.action == "oom") {
+            logger.warn("Task %s in container %s ran out of memory",
+                        ct.taskId.c_str(), ev.contId.c_str());
+        } else if (ev.action == "die") {
+            ct.exited = true;
+            ct.exitCode = ev.exitCode;
+        }
+    }
+}
+
 //----------------------------------------------------------------------
 // Method: monitorTasks
-// Monitor running container
+// Monitor running containers.  If container events are being received,
+// only the containers that exited are inspected
 //----------------------------------------------------------------------
 void TaskAgent::monitorTasks()
 {
-    string contId;
+    bool inspectAll = (! eventsLive) || resyncNeeded;
+    resyncNeeded = false;
 
-    // Check status of current container
-    if (containerId.empty()) {
-        if (taskQueue.empty()) { return; }
+    auto it = containers.begin();
+    while (it != containers.end()) {
+        const string & contId = it->first;
+        ContainerTask & ct = it->second;
 
-        contId = launchNewTask();
-        if (contId.empty()) { return; }
-        
-        // Send information of new container
-        logger.info("New task launched in container: " + contId);
-        containerId = contId;
-        containerSpectrum.append(contId, statusStr);
-    } else {
-        contId = containerId;
+        if ((! inspectAll) && (! ct.exited)) {
+            ++it;
+            continue;
+        }
+
+        // Auto-removed containers may be gone already, so the exit code
+        // of the die event is used
+        string inspect;
+        if (ct.autoRemoved && ct.exited) {
+            inspect = exitedContainerInfo(contId, ct.info, ct.exitCode);
+        } else {
+            inspect = inspectContainer(contId, ct.io);
+            if (inspect.empty() && ct.autoRemoved) {
+                logger.warn("Container %s of task %s is gone",
+                            contId.c_str(), ct.taskId.c_str());
+                inspect = exitedContainerInfo(contId, ct.info, -1);
+            }
+        }
+        if (! inspect.empty()) {
+            json jinspect = json::parse(inspect);
+            string statusStr = jinspect["Task_Status"].get<string>();
+            ct.status = TaskStatusEnum(TaskStatusVal[statusStr]);
+
+            // A copy of a task finished after another one is aborted, and
+            // its outputs discarded
+            if ((ct.status == TASK_FINISHED) && ct.killReason.empty() &&
+                (! claimOutputs(ct.processor, ct.group))) {
+                logger.info("Task %s finished after another copy of it",
+                            ct.taskId.c_str());
+                ct.killReason = "superseded";
+            }
+
+            // Tasks killed by the watchdog are failed, whatever the
+            // exit code of the container, and cancelled ones are aborted
+            bool killed = ((! ct.killReason.empty()) &&
+                           TaskStatus(ct.status).isEnded());
+            bool hung = killed && (ct.killReason == "timeout" ||
+                                   ct.killReason == "stalled");
+            if (killed && (! hung)) {
+                ct.status = TASK_ABORTED;
+                jinspect["Task_Status"] = "ABORTED";
+                inspect = jinspect.dump();
+            } else if (hung) {
+                ct.status = TASK_FAILED;
+                jinspect["Task_Status"] = "FAILED";
+                jinspect["Watchdog"] = {{"reason", ct.killReason}};
+                inspect = jinspect.dump();
+            }
+            ct.info = jinspect;
+            sendTaskStatus(TaskStatusUpdate {false, ct.taskId, contId, inspect,
+                                             1, ct.status, hung});
+            containerSpectrum.append(contId, ct.status);
+        } else {
+            logger.warn("Couldn't get inspection information from container " + contId);
+        }
+
+        // If finished, free its slot
+        if (TaskStatus(ct.status).isEnded()) {
+            logger.debug("Task %s ended in container %s",
+                         ct.taskId.c_str(), contId.c_str());
+            std::set<string> handedOver;
+            if (ow != nullptr) { ow->unwatch(ct.taskFolder, handedOver); }
+            if (ct.killReason.empty()) {
+                prepareOutputs(ct.taskFolder, handedOver);
+            } else {
+                removePartialOutputs(ct.taskFolder, handedOver);
+            }
+            if (! ct.autoRemoved) { scheduleContainerForRemoval(contId); }
+            if (! ct.procClass.empty()) { classInUse[ct.procClass]--; }
+            if (ct.cpuSlot >= 0) { cpuSlotInUse[ct.cpuSlot] = false; }
+            it = containers.erase(it);
+        } else {
+            ++it;
+        }
     }
+}
 
-    inspectSelection = (InspectSelection1 +
-                        (iAmQuitting ? "RUNNING" : "STOPPED") +
-                        InspectSelection2);
+//----------------------------------------------------------------------
+// Method: watchTasks
+// Kills the running tasks that exceed the wall-clock limit of their
+// processor, or whose logs did not grow for the allowed stall time.
+// Returns whether some task is being watched
+//----------------------------------------------------------------------
+bool TaskAgent::watchTasks()
+{
+    bool someWatched = false;
+    hires_time now = timeNow();
 
-    inspect = inspectContainer(contId, false, inspectSelection);
-    if (! inspect.empty()) {
-        json jinspect = json::parse(inspect);
-        statusStr = jinspect["Task_Status"].get<string>();
-        status = TaskStatusEnum(TaskStatusVal[statusStr]);
-        for (auto & s : vector<string> {"false", taskId, contId,
-		    inspect, "1", statusStr}) {
-            tq->push(std::move(s));
+    for (auto & kv: containers) {
+        ContainerTask & ct = kv.second;
+        if ((! ct.killReason.empty()) || TaskStatus(ct.status).isEnded()) {
+            continue;
         }
 
-        containerSpectrum.append(contId, statusStr);
-    } else {
-        logger.warn("Couldn't get inspection information from container " + contId);
+        // A kill that failed before is tried again
+        if (! ct.killPending.empty()) {
+            someWatched = true;
+            killContainer(kv.first, ct.killPending);
+            continue;
+        }
+
+        if ((ct.limits.timeLimit < 1) && (ct.limits.stallTime < 1)) {
+            continue;
+        }
+        someWatched = true;
+
+        string reason;
+        if ((ct.limits.timeLimit > 0) &&
+            (now - ct.started > seconds(ct.limits.timeLimit))) {
+            reason = "timeout";
+        } else if (ct.limits.stallTime > 0) {
+            long long size = taskLogSize(ct.taskFolder);
+            if (size != ct.logSize) {
+                ct.logSize = size;
+                ct.lastProgress = now;
+            } else if (now - ct.lastProgress > seconds(ct.limits.stallTime)) {
+                reason = "stalled";
+            }
+        }
+        if (reason.empty()) { continue; }
+
+        logger.warn("Task %s in container %s %s, killing it",
+                    ct.taskId.c_str(), kv.first.c_str(),
+                    (reason == "timeout") ? "timed out" : "stalled");
+        killContainer(kv.first, reason);
     }
 
-    sendSpectrumToMng();
+    return someWatched;
+}
+
+//----------------------------------------------------------------------
+// Method: cancelTask
+// Withdraws a task, because another copy of it finished first: it is
+// just dropped if still queued, or its container is killed otherwise
+//----------------------------------------------------------------------
+void TaskAgent::cancelTask(string & taskId)
+{
+    for (auto it = taskQueue.begin(); it != taskQueue.end(); ++it) {
+        if (it->taskId != taskId) { continue; }
+        taskQueue.erase(it);
+        logger.info("Task %s cancelled before launch", taskId.c_str());
+        sendTaskStatus(TaskStatusUpdate {true, taskId, "", "{}", 0, TASK_ABORTED});
+        return;
+    }
+
+    for (auto & kv: containers) {
+        ContainerTask & ct = kv.second;
+        if ((ct.taskId != taskId) || (! ct.killReason.empty()) ||
+            TaskStatus(ct.status).isEnded()) { continue; }
+        logger.info("Task %s cancelled, killing container %s",
+                    taskId.c_str(), kv.first.c_str());
+        killContainer(kv.first, "cancelled");
+        return;
+    }
+}
 
-    // If finished, set current container to None
-    // (TBD: and remove info from internal lists and dicts)
-    if (status.isEnded()) {
-        logger.debug("!!!!!!!!!!!!!!!! ENDED !!!!!!!!!!!!!!");
-        prepareOutputs();
-        scheduleContainerForRemoval();
+//----------------------------------------------------------------------
+// Method: killContainer
+// Kills the container of a task.  The reason is recorded only once the
+// container is actually killed, otherwise the kill is left pending, to
+// be tried again in the next watch pass
+//----------------------------------------------------------------------
+void TaskAgent::killContainer(const string & contId, string reason)
+{
+    ContainerTask & ct = containers.at(contId);
+    if (dckMng->kill(contId)) {
+        ct.killReason = reason;
+        ct.killPending.clear();
+        return;
+    }
+    if (ct.killPending.empty()) {
+        logger.error("Cannot kill container %s, will try again",
+                     contId.c_str());
     }
+    ct.killPending = reason;
 }
 
 //----------------------------------------------------------------------
-// Method: delay
-// Waits for a small time lapse for system sync
+// Method: claimOutputs
+// Claims the outputs of a finished task of a processor executed
+// speculatively.  Only the first copy of the task to finish gets them
 //----------------------------------------------------------------------
-void TaskAgent::delay(int ms)
+bool TaskAgent::claimOutputs(const string & processor, const string & group)
 {
-    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    if ((claims == nullptr) ||
+        (std::find(settings.speculative.begin(), settings.speculative.end(),
+                   processor) == settings.speculative.end())) {
+        return true;
+    }
+    return claims->claim(group);
+}
+
+//----------------------------------------------------------------------
+// Method: taskLogSize
+// Returns the total size of the log files of the task, either in its
+// log folder or the output captured in the task folder
+//----------------------------------------------------------------------
+long long TaskAgent::taskLogSize(const string & taskFolder)
+{
+    long long size = 0;
+    struct stat st;
+
+    for (auto & f: {"/container.log", "/native.log"}) {
+        if (stat((taskFolder + f).c_str(), &st) == 0) { size += st.st_size; }
+    }
+
+    int fd = open((taskFolder + "/log").c_str(),
+                  O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) { return size; }
+    DIR * dir = fdopendir(fd);
+    if (dir == nullptr) {
+        close(fd);
+        return size;
+    }
+    struct dirent * ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        if ((fstatat(fd, ent->d_name, &st, 0) == 0) && S_ISREG(st.st_mode)) {
+            size += st.st_size;
+        }
+    }
+    closedir(dir);
+    return size;
+}
+
+//----------------------------------------------------------------------
+// Method: removePartialOutputs
+// Removes the outputs left by a task killed by the watchdog, or by a
+// discarded copy of a task, so that they are not taken as products,
+// nor found by a retry of the task.  Outputs already handed over to
+// the main loop are left alone, as they are being archived
+//----------------------------------------------------------------------
+void TaskAgent::removePartialOutputs(const string & taskFolder,
+                                     std::set<string> & handedOver)
+{
+    string outFolder = taskFolder + "/out/";
+    int fd = open((taskFolder + "/out").c_str(),
+                  O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) { return; }
+    DIR * dir = fdopendir(fd);
+    if (dir == nullptr) {
+        close(fd);
+        return;
+    }
+    struct dirent * ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        struct stat st;
+        if (handedOver.count(outFolder + ent->d_name) > 0) { continue; }
+        if ((fstatat(fd, ent->d_name, &st, 0) == 0) && S_ISREG(st.st_mode)) {
+            (void)unlinkat(fd, ent->d_name, 0);
+        }
+    }
+    closedir(dir);
 }
 
 //----------------------------------------------------------------------
@@ -538,69 +940,72 @@ TaskAgent::hires_time TaskAgent::timeNow()
 }
 
 //----------------------------------------------------------------------
-// Method: init
-// Initialize the component
+// Method: nextStepDelay
+// Computes the time until the next step is needed: the container
+// launch settling time, the heart beat while a container is being
+// polled, or the watchdog period while a task has limits.  Container
+// events wake the agent up, so no polling is needed while they arrive
+//----------------------------------------------------------------------
+int TaskAgent::nextStepDelay(bool justLaunched)
+{
+    bool polling = (! eventsLive);
+    if (! unsentStatus.empty()) { return DelayAgentMainLoop; }
+    if (justLaunched && polling) { return DelayAfterContainerLaunch; }
+    if ((! containers.empty()) && polling) { return settings.heartBeat; }
+    if (watching) { return DelayWatchdogCheck; }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// Method: step
+// Runs one step of the agent: gathers the new tasks, monitors the
+// running containers and launches new ones if there are free slots
 //----------------------------------------------------------------------
-void TaskAgent::run()
+int TaskAgent::step()
 {
-    forever {
-
-        // Check if new task data available
-        if (! iq->empty()) {
-            // Gather new task info from input queue, and store in internal queue
-            string itaskId, itaskFolder, iprocessor;
-            iq->get(itaskId);
-            iq->get(itaskFolder);
-            iq->get(iprocessor);
-
-            logger.debug("New task id queued at Task Agent %s: %s",
-                         id.c_str(), itaskId.c_str());
-            logger.debug("Execution to be done in work. dir. %s",
-                         itaskFolder.c_str());
-            logger.debug("Processor to use: %s", iprocessor.c_str());
-            taskQueue.push(std::move(itaskId));
-            taskQueue.push(std::move(itaskFolder));
-            taskQueue.push(std::move(iprocessor));
+    TaskAssignment task;
+    bool justLaunched = false;
+
+    // Gather new tasks from input channel, and store in internal queue
+    while (iq->tryPop(task)) {
+        if (task.cancel) {
+            cancelTask(task.taskId);
+            continue;
         }
+        logger.debug("New task id queued at Task Agent %s: %s",
+                     id.c_str(), task.taskId.c_str());
+        logger.debug("Execution to be done in work. dir. %s",
+                     task.taskFolder.c_str());
+        logger.debug("Processor to use: %s", task.processor.c_str());
+        taskQueue.push_back(std::move(task));
+    }
 
-        // Monitor running container
+    // Apply the container events, and monitor running containers
+    processContainerEvents();
+    if (! containers.empty()) {
         monitorTasks();
+    }
+    watching = watchTasks();
 
-        // Remove old containers
-        removeOldContainers();
+    // Launch next tasks, while there are free slots for them
+    while (selectNextTask(task)) {
+        string contId = launchNewTask(task);
+        if (contId.empty()) { continue; }
 
-        // Minor sleep
-        delay(DelayAgentMainLoop);
-        
+        logger.info("New task launched in container: " + contId);
+        containerSpectrum.append(contId, containers.at(contId).status);
+        justLaunched = true;
     }
-}
 
-const string TaskAgent::InspectSelection1("{{- define \"CheckCode\" -}}"
-                                          "{{- $c := printf \"%s\" .ExitCode -}}"
-                                          "{{- if eq $c \"0\" -}}\"FINISHED\""
-                                          "{{- else if le $c \"128\" -}}\"FAILED\""
-                                          "{{- else if ge $c \"160\" -}}\"FAILED\""
-                                          "{{- else -}}\"");
-const string TaskAgent::InspectSelection2("\""
-                                          "{{- end -}}"
-                                          "{{- end -}}"
-                                          "{{-  define \"TaskStatus\" -}}"
-                                          "{{- if eq .Status \"running\" -}}\"RUNNING\""
-                                          "{{- else if eq .Status \"paused\" -}}\"PAUSED\""
-                                          "{{- else if eq .Status \"created\" -}}\"ABORTED\""
-                                          "{{- else if eq .Status \"dead\" -}}\"STOPPED\""
-                                          "{{- else if eq .Status \"exited\" -}}{{- template \"CheckCode\" . -}}"
-                                          "{{- else -}}\"UNKNOWN_STATE\""
-                                          "{{- end -}}"
-                                          "{{- end -}}"
-                                          "{\"Id\":{{- json .Id -}}"
-                                          ",\"State\":{{- json .State -}}"
-                                          ",\"Path\":{{- json .Path -}}"
-                                          ",\"Args\":{{- json .Args -}}"
-                                          ",\"Config\":{{- json .Config -}}"
-                                          ",\"Task_Status\":{{template \"TaskStatus\" .State}}}");
+    // Send information of the containers, if there were changes
+    sendSpectrumToMng();
+    flushTaskStatus();
+
+    return nextStepDelay(justLaunched);
+}
 
 const int TaskAgent::DelayAgentMainLoop = 333;
 const int TaskAgent::DelayAfterContainerLaunch = 1000;
+const int TaskAgent::DelayWatchdogCheck = 1000;
 
-const double TaskAgent::DelayForEndedContainerRemoval = 180000.;  // 180 s = 3 min
+const int TaskAgent::DelayForEndedContainerRemoval = 180000;  // 180 s = 3 min
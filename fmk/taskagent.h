@@ -51,6 +51,8 @@
 //------------------------------------------------------------
 #include <ctime>
 #include <chrono>
+#include <deque>
+#include <set>
 using namespace std::chrono;
 
 //------------------------------------------------------------
@@ -63,10 +65,17 @@ using namespace std::chrono;
 //------------------------------------------------------------
 #include "types.h"
 #include "wa.h"
-#include "q.h"
+#include "agentmsg.h"
 #include "cs.h"
 
 #include "cntrmng.h"
+#include "dckapimng.h"
+#include "nativemng.h"
+#include "warmpool.h"
+#include "cntrgc.h"
+#include "proccfg.h"
+#include "outwatch.h"
+#include "taskclaims.h"
 
 //==========================================================================
 // Class: TaskAgent
@@ -80,8 +89,11 @@ public:
     // Method: TaskAgent
     //----------------------------------------------------------------------
     TaskAgent(WorkArea _wa, string _ident,
-              Queue<string> * _iq, Queue<string> * _oq, Queue<string> * _tq,
-              bool _isCommander);
+              TaskAssignmentRing * _iq, SpectrumUpdateRing * _oq,
+              TaskStatusUpdateRing * _tq, ContainerEventRing * _eq,
+              ContainerCollector * _gc, OutputWatcher * _ow,
+              OutputHandoff * _handoff, TaskClaims * _claims,
+              bool _isCommander, AgentSettings _settings);
 
     //----------------------------------------------------------------------
     // Destructor
@@ -89,9 +101,14 @@ public:
     virtual ~TaskAgent();
 
     //----------------------------------------------------------------------
-    // Method: run
+    // Method: step
+    // Runs one step of the agent, and returns the delay in ms until the
+    // next one is needed (negative if only new tasks require it)
     //----------------------------------------------------------------------
-    void run();
+    int step();
+
+    // Label identifying the agent that owns a container
+    static const string QPFContainerLabel;
 
 protected:
 
@@ -101,77 +118,92 @@ private:
     //----------------------------------------------------------------------
     virtual void init();
 
+    //----------------------------------------------------------------------
+    // Method: createContainerMng
+    //----------------------------------------------------------------------
+    std::shared_ptr<DockerMng> createContainerMng();
+
     //----------------------------------------------------------------------
     // Method: getFiles
     // Get the files according to a item expresion (i.e.: in/*.fits)
     //----------------------------------------------------------------------
-    vector<string> getFiles(string item);
+    vector<string> getFiles(int dirFd, string item);
     
     //----------------------------------------------------------------------
-    // Method: substitute
+    // Method: sendSpectrumToMng
     //----------------------------------------------------------------------
-    string substitute(string value, string rule);
+    void sendSpectrumToMng();
 
     //----------------------------------------------------------------------
-    // Method: get_substitution_rules
+    // Method: sendTaskStatus
     //----------------------------------------------------------------------
-    std::tuple< string, vector<string> > getSubstitutionRules(string item);
+    void sendTaskStatus(TaskStatusUpdate && upd);
 
     //----------------------------------------------------------------------
-    // Method: isSubstitutionRules
+    // Method: flushTaskStatus
     //----------------------------------------------------------------------
-    bool isSubstitutionRules(string item);
+    void flushTaskStatus();
 
     //----------------------------------------------------------------------
-    // Method: isEnded
+    // Method: prepareNewTask
     //----------------------------------------------------------------------
-    bool isEnded(TaskStatus st);
+    bool prepareNewTask(string taskId, string taskFld, string proc);
 
     //----------------------------------------------------------------------
-    // Method: doRules
+    // Method: launchContainer
     //----------------------------------------------------------------------
-    vector<string> doRules(string item);
+    bool launchContainer(string & taskId, string & contId, bool & warm,
+                         vector<string> & pinOpts);
 
     //----------------------------------------------------------------------
-    // Method: sendSpectrumToMng
+    // Method: acquireCpuSlot
     //----------------------------------------------------------------------
-    void sendSpectrumToMng();
+    int acquireCpuSlot(string & proc, vector<string> & pinOpts);
 
     //----------------------------------------------------------------------
-    // Method: prepareNewTask
+    // Method: inspectContainer
     //----------------------------------------------------------------------
-    bool prepareNewTask(string taskId, string taskFld, string proc);
+    string inspectContainer(string cntId, json & io);
 
     //----------------------------------------------------------------------
-    // Method: launchContainer
+    // Method: taskStatusFromState
+    //----------------------------------------------------------------------
+    string taskStatusFromState(json & state);
+    
+    //----------------------------------------------------------------------
+    // Method: launchNewTask
     //----------------------------------------------------------------------
-    bool launchContainer(string & contId);
+    std::string launchNewTask(TaskAssignment & task);
 
     //----------------------------------------------------------------------
-    // Method: inspectContainer
+    // Method: selectNextTask
     //----------------------------------------------------------------------
-    string inspectContainer(string cntId, bool fullInfo = true,
-                            string filter = string(""));
-    
+    bool selectNextTask(TaskAssignment & task);
+
     //----------------------------------------------------------------------
-    // Method: launchNewTask
+    // Method: reportFailedLaunch
     //----------------------------------------------------------------------
-    std::string launchNewTask();
+    void reportFailedLaunch(std::string & ntaskId);
 
     //----------------------------------------------------------------------
     // Method: scheduleContainerForRemoval
     //----------------------------------------------------------------------
-    void scheduleContainerForRemoval();
+    void scheduleContainerForRemoval(string contId);
 
     //----------------------------------------------------------------------
-    // Method: removeOldContainers
+    // Method: exitedContainerInfo
     //----------------------------------------------------------------------
-    void removeOldContainers();
+    string exitedContainerInfo(const string & contId, json & info, int exitCode);
 
     //----------------------------------------------------------------------
     // Method: prepareOutputs
     //----------------------------------------------------------------------
-    void prepareOutputs();
+    void prepareOutputs(string & taskFolder, std::set<string> & handedOver);
+
+    //----------------------------------------------------------------------
+    // Method: processContainerEvents
+    //----------------------------------------------------------------------
+    void processContainerEvents();
 
     //----------------------------------------------------------------------
     // Method: monitorTasks
@@ -179,11 +211,41 @@ private:
     void monitorTasks();
 
     //----------------------------------------------------------------------
-    // Method: delay
-    // Waits for a small time lapse for system sync
+    // Method: watchTasks
     //----------------------------------------------------------------------
-    void delay(int ms);
-    
+    bool watchTasks();
+
+    //----------------------------------------------------------------------
+    // Method: cancelTask
+    //----------------------------------------------------------------------
+    void cancelTask(string & taskId);
+
+    //----------------------------------------------------------------------
+    // Method: killContainer
+    //----------------------------------------------------------------------
+    void killContainer(const string & contId, string reason);
+
+    //----------------------------------------------------------------------
+    // Method: claimOutputs
+    //----------------------------------------------------------------------
+    bool claimOutputs(const string & processor, const string & group);
+
+    //----------------------------------------------------------------------
+    // Method: taskLogSize
+    //----------------------------------------------------------------------
+    long long taskLogSize(const string & taskFolder);
+
+    //----------------------------------------------------------------------
+    // Method: removePartialOutputs
+    //----------------------------------------------------------------------
+    void removePartialOutputs(const string & taskFolder,
+                              std::set<string> & handedOver);
+
+    //----------------------------------------------------------------------
+    // Method: nextStepDelay
+    //----------------------------------------------------------------------
+    int nextStepDelay(bool justLaunched);
+
     //----------------------------------------------------------------------
     // Method: timeNow
     // Returns a high resolution clock time stamp
@@ -193,32 +255,60 @@ private:
 private:
     string id;
     WorkArea wa;
-    Queue<string> * iq;
-    Queue<string> * oq;
-    Queue<string> * tq;
+    TaskAssignmentRing * iq;
+    SpectrumUpdateRing * oq;
+    TaskStatusUpdateRing * tq;
+    ContainerEventRing * eq;
+    ContainerCollector * gc;
+    OutputWatcher * ow;
+    OutputHandoff * handoff;
+    TaskClaims * claims;
     bool isCommander;
+    AgentSettings settings;
 
     bool iAmQuitting;
+    bool eventsLive;
+    bool resyncNeeded;
+    bool watching;
     
-    Queue<string> taskQueue;
+    std::deque<TaskAssignment> taskQueue;
+    std::deque<TaskStatusUpdate> unsentStatus;
+
+    struct ContainerTask {
+        string         taskId;
+        string         taskFolder;
+        string         processor;
+        string         group;
+        string         procClass;
+        TaskStatusEnum status;
+        json           io;
+        json           info;
+        bool           exited;
+        int            exitCode;
+        bool           autoRemoved;
+        int            cpuSlot;
+        TaskLimits     limits;
+        hires_time     started;
+        hires_time     lastProgress;
+        long long      logSize;
+        string         killReason;
+        string         killPending;
+    };
+
+    map<string, ContainerTask> containers;
+    map<string, int> classInUse;
+    vector<bool> cpuSlotInUse;
 
-    string taskId;
-    string taskFolder;
-    string processor;
-    string containerId;
     ContainerSpectrum containerSpectrum;
-    string inspect;
-    TaskStatus status;
-    string statusStr;
 
     string uid;
     string uname;
+    vector<string> userOpts;
     
-    vector< pair<hires_time, string> > containersToRemove;
-    
-    std::shared_ptr<ContainerMng> dckMng;
+    std::shared_ptr<DockerMng> dckMng;
+    std::shared_ptr<WarmContainerPool> warmPool;
 
-    Config pcfg;
+    ProcessorConfigCache procCfgs;
     string i_input;
     string i_output;
     string i_log;
@@ -234,20 +324,16 @@ private:
     string dck_workdir;
     map<string, string> dck_mapping;
 
-    string inspectSelection;
-    
     Logger logger;
 
     static const string QPFDckImageDefault;
     static const string QPFDckImageRunPath;
     static const string QPFDckImageProcPath;
 
-    static const string InspectSelection1;
-    static const string InspectSelection2;
-
     static const int DelayAgentMainLoop;
     static const int DelayAfterContainerLaunch;
-    static const double DelayForEndedContainerRemoval;
+    static const int DelayWatchdogCheck;
+    static const int DelayForEndedContainerRemoval;
 };
 
 #endif // TASKAGENT_H
@@ -0,0 +1,73 @@
+/******************************************************************************
+ * File:    taskclaims.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.TaskClaims
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement TaskClaims class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#include "taskclaims.h"
+
+//----------------------------------------------------------------------
+// Method: claim
+// Claims the outputs of the task, returning false if another copy
+// of it already did
+//----------------------------------------------------------------------
+bool TaskClaims::claim(const std::string & taskId)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return claimed.insert(taskId).second;
+}
+
+//----------------------------------------------------------------------
+// Method: open
+// Opens the task for a duplicate, unless it is already claimed
+//----------------------------------------------------------------------
+bool TaskClaims::open(const std::string & taskId)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return (claimed.count(taskId) == 0);
+}
+
+//----------------------------------------------------------------------
+// Method: release
+// Forgets the task, once all its copies ended
+//----------------------------------------------------------------------
+void TaskClaims::release(const std::string & taskId)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    claimed.erase(taskId);
+}
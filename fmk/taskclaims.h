@@ -0,0 +1,100 @@
+/******************************************************************************
+ * File:    taskclaims.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.TaskClaims
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare TaskClaims class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#ifndef TASKCLAIMS_H
+#define TASKCLAIMS_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//   - set
+//   - mutex
+//------------------------------------------------------------
+#include <string>
+#include <set>
+#include <mutex>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+
+//==========================================================================
+// Class: TaskClaims
+// Decides which copy of a speculatively executed task delivers its
+// outputs: the first one to finish claims the task, and the others
+// must discard theirs.  A task already claimed cannot be duplicated
+//==========================================================================
+class TaskClaims {
+
+public:
+    //----------------------------------------------------------------------
+    // Method: claim
+    // Claims the outputs of the task, returning false if another copy
+    // of it already did
+    //----------------------------------------------------------------------
+    bool claim(const std::string & taskId);
+
+    //----------------------------------------------------------------------
+    // Method: open
+    // Opens the task for a duplicate, unless it is already claimed
+    //----------------------------------------------------------------------
+    bool open(const std::string & taskId);
+
+    //----------------------------------------------------------------------
+    // Method: release
+    // Forgets the task, once all its copies ended
+    //----------------------------------------------------------------------
+    void release(const std::string & taskId);
+
+private:
+    std::mutex mtx;
+    std::set<std::string> claimed;
+};
+
+#endif // TASKCLAIMS_H
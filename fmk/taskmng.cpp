@@ -44,11 +44,18 @@
 #include "tools.h"
 #include "filetools.h"
 #include "prodloc.h"
+#include "copyeng.h"
 #include "str.h"
 #include "dwatcher.h"
 #include "types.h"
 
 #include <fstream>
+#include <algorithm>
+#include <thread>
+
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "json.hpp"
 using json = nlohmann::json;
@@ -59,12 +66,23 @@ using json = nlohmann::json;
 TaskManager::TaskManager(Config & _cfg, string _id, 
                          WorkArea & _wa, ProcessingNetwork & _net)
     : cfg(_cfg), id(_id), wa(_wa), net(_net),
+      agentsExec(nullptr), dckEvents(nullptr), cntrCollector(nullptr),
+      outWatcher(nullptr), outHandoff(nullptr),
       defaultProcCfg(std::string("sample.cfg.json")),
+      hostMon(_wa.wa),
+      tskFolders(_wa.tasks),
       logger(Log::getLogger("tskmng"))
 {
     thisNodeNum = indexOf<string>(net.nodeName, id);
+    setAgentSettings();
+    setCpuPinning();
+    setTaskWatchdog();
+    setSpeculation();
     logger.info("Task Manager created");
 
+    hostMon.start();
+    tskFolders.start();
+
     setDirectoryWatchers();
 }
 
@@ -76,6 +94,149 @@ TaskManager::~TaskManager()
     terminate();
 }
 
+//----------------------------------------------------------------------
+// Method: setAgentSettings
+// Set the agents heart beat and container backend, the number of
+// concurrent containers per agent in this node, and the limits for
+// each processor class (from orchestration section)
+//----------------------------------------------------------------------
+void TaskManager::setAgentSettings()
+{
+    json & gen = cfg["general"];
+    agentsHeartBeat = gen.value("agentsHeartBeat", 333.);
+    agentSettings.heartBeat = (int)(agentsHeartBeat);
+    agentSettings.containerBackend = gen.value("containerBackend", "cli");
+    agentSettings.dockerSocket = gen.value("dockerSocket",
+                                           "/var/run/docker.sock");
+    agentSettings.containerEvents = gen.value("containerEvents", false);
+    if (gen.count("nativeCgroup") > 0) {
+        for (auto & kv: gen["nativeCgroup"].items()) {
+            agentSettings.nativeCgroup[kv.key()] = kv.value().get<string>();
+        }
+    }
+    agentSettings.autoRemove = gen.value("containerAutoRemove", false);
+    if (agentSettings.autoRemove &&
+        ((! agentSettings.containerEvents) ||
+         (agentSettings.containerBackend == "native"))) {
+        logger.warn("Container auto-removal requires container events");
+        agentSettings.autoRemove = false;
+    }
+    if (gen.count("warmContainers") > 0) {
+        for (auto & kv: gen["warmContainers"].items()) {
+            agentSettings.warmPool[kv.key()] = kv.value().get<int>();
+        }
+    }
+
+    AgentSlots & agentSlots = agentSettings.slots;
+    agentSlots.total = net.thisNodeAgentSlots;
+
+    json & orc = cfg["orchestration"];
+    if (orc.count("processorClasses") < 1) { return; }
+
+    for (auto & kv: orc["processorClasses"].items()) {
+        const string & procClass = kv.key();
+        json & cls = kv.value();
+        for (auto & proc: cls["processors"]) {
+            agentSlots.procClass[proc.get<string>()] = procClass;
+        }
+        agentSlots.classLimit[procClass] = cls.value("slots", agentSlots.total);
+        logger.debug("Processor class %s limited to %d containers per agent",
+                     procClass.c_str(), agentSlots.classLimit[procClass]);
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: setCpuPinning
+// Split the CPUs of the node into disjoint sets, one per container slot
+// of each agent, if requested in the cpuPinning section of the
+// orchestration settings: the CPUs to use, the default pinning mode
+// and the mode for specific processors.  Modes are: slot (the CPU set
+// of the slot), node (all the CPUs of its NUMA nodes) or none
+//----------------------------------------------------------------------
+void TaskManager::setCpuPinning()
+{
+    agentSettings.defaultPinning = "none";
+
+    json & orc = cfg["orchestration"];
+    if (orc.count("cpuPinning") < 1) { return; }
+    json & pin = orc["cpuPinning"];
+    if (! pin.value("enabled", false)) { return; }
+
+    agentSettings.defaultPinning = pin.value("default", "slot");
+    if (pin.count("processors") > 0) {
+        for (auto & kv: pin["processors"].items()) {
+            agentSettings.procPinning[kv.key()] = kv.value().get<string>();
+        }
+    }
+
+    CpuInventory inv(pin.value("cpus", ""));
+    int numOfSlots = (net.nodeNumOfAgents[thisNodeNum] *
+                      agentSettings.slots.total);
+    agentsCpuSlots = inv.partition(numOfSlots);
+    for (size_t i = 0; i < agentsCpuSlots.size(); ++i) {
+        logger.debug("Container slot %d: CPUs %s, NUMA nodes %s", (int)(i),
+                     agentsCpuSlots.at(i).cpus.c_str(),
+                     agentsCpuSlots.at(i).mems.c_str());
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: setTaskWatchdog
+// Set the limits of the tasks (wall-clock time, and time without log
+// growth, in seconds), by default and for specific processors, and the
+// number of times a task killed by the watchdog is launched again,
+// with a delay (in seconds) doubled for each retry
+//----------------------------------------------------------------------
+void TaskManager::setTaskWatchdog()
+{
+    agentSettings.defaultLimits = TaskLimits {0, 0};
+    maxTaskRetries = 0;
+    taskRetryDelay = 30;
+
+    json & orc = cfg["orchestration"];
+    if (orc.count("watchdog") < 1) { return; }
+    json & wd = orc["watchdog"];
+
+    agentSettings.defaultLimits = TaskLimits {wd.value("timeLimit", 0),
+                                              wd.value("stallTime", 0)};
+    if (wd.count("processors") > 0) {
+        for (auto & kv: wd["processors"].items()) {
+            json & lim = kv.value();
+            agentSettings.procLimits[kv.key()] =
+                TaskLimits {lim.value("timeLimit", agentSettings.defaultLimits.timeLimit),
+                            lim.value("stallTime", agentSettings.defaultLimits.stallTime)};
+        }
+    }
+    maxTaskRetries = wd.value("maxRetries", 0);
+    taskRetryDelay = wd.value("retryDelay", 30);
+}
+
+//----------------------------------------------------------------------
+// Method: setSpeculation
+// Set the processors whose straggler tasks are executed again in an
+// idle agent: a copy of the task is launched when it runs longer than
+// the given percentile of the recent run times of the processor
+// (once enough of them are known), and the first copy to finish wins
+//----------------------------------------------------------------------
+void TaskManager::setSpeculation()
+{
+    specPercentile = 90;
+    specMinSamples = 10;
+
+    json & orc = cfg["orchestration"];
+    if (orc.count("speculation") < 1) { return; }
+    json & spc = orc["speculation"];
+    if (! spc.value("enabled", false)) { return; }
+
+    if (spc.count("processors") > 0) {
+        for (auto & p: spc["processors"]) {
+            agentSettings.speculative.push_back(p.get<string>());
+        }
+    }
+    specPercentile = std::min(std::max(spc.value("percentile", 90), 50), 99);
+    specMinSamples = std::max(spc.value("minSamples", 10), 1);
+}
+
 //----------------------------------------------------------------------
 // Method: setDirectoryWatchers
 //----------------------------------------------------------------------
@@ -132,12 +293,26 @@ bool TaskManager::getNewEntriesFromDirWatcher(DirWatcher * dw, Queue<string> & q
 // Method: createAgent
 //----------------------------------------------------------------------
 void TaskManager::createAgent(string id, WorkArea wa,
-                 Queue<string> * iq, Queue<string> * oq, Queue<string> * tq,
+                 TaskAssignmentRing * iq, SpectrumUpdateRing * oq,
+                 TaskStatusUpdateRing * tq, ContainerEventRing * eq,
                  bool isComm)
 {
-    TaskAgent * agent = new TaskAgent(wa, id, iq, oq, tq, isComm);
+    // Each agent takes the CPU sets of its own container slots
+    AgentSettings settings(agentSettings);
+    size_t first = agents.size() * settings.slots.total;
+    if (agentsCpuSlots.size() >= first + settings.slots.total) {
+        settings.cpuSlots.assign(agentsCpuSlots.begin() + first,
+                                 agentsCpuSlots.begin() + first +
+                                 settings.slots.total);
+    }
+
+    TaskClaims * claims = (settings.speculative.empty() ?
+                           nullptr : &taskClaims);
+    TaskAgent * agent = new TaskAgent(wa, id, iq, oq, tq, eq, cntrCollector,
+                                      outWatcher, outHandoff, claims,
+                                      isComm, settings);
     agents.push_back(agent);
-    agentThreads.push_back(std::thread(&TaskAgent::run, agent));
+    agentsHandle.push_back(agentsExec->add([agent](){ return agent->step(); }));
 }
 
 //----------------------------------------------------------------------
@@ -151,41 +326,36 @@ void TaskManager::createAgents()
     logger.info("Creating %d processing agents for node %s. . .",
                 numOfAgents, id.c_str());
 
-     json agentData = {{"num_tasks", 0},
-                       {"task_id", std::string("")},
-                       {"cont_id", std::string("")},
-                       {"cont_status", -99},
-                       {"spectrum", {{"ABORTED", 0},
-                                     {"ARCHIVED", 0},
-                                     {"FAILED", 0},
-                                     {"FINISHED", 0},
-                                     {"PAUSED", 0},
-                                     {"RUNNING", 0},
-                                     {"SCHEDULED", 0},
-                                     {"STOPPED", 0}}}};
-    
-    json agentsData;
-    json agentsNames;
-    json agentsTasks;
+    // Agents are run on a small pool of workers, each of them driven by
+    // new tasks and by its own timers
+    int numOfWorkers = std::max(2, (int)(std::thread::hardware_concurrency()));
+    agentsExec = new AgentExecutor(std::min(numOfAgents, numOfWorkers));
+
+    createCollector();
+
+    // Outputs are handed over directly to the main loop, unless they
+    // are to go through the inbox folder as external products do
+    if (cfg["general"].value("outputHandoff", true)) {
+        outHandoff = new OutputHandoff;
+    }
+    createOutputWatcher();
 
     for (int i = 0; i < numOfAgents; ++i) {
-        Queue<string> * iq = new Queue<string>;
-        Queue<string> * oq = new Queue<string>;
-        Queue<string> * tq = new Queue<string>;
+        TaskAssignmentRing * iq = new TaskAssignmentRing;
+        SpectrumUpdateRing * oq = new SpectrumUpdateRing;
+        TaskStatusUpdateRing * tq = new TaskStatusUpdateRing;
+        ContainerEventRing * eq = (agentSettings.containerEvents ?
+                                   new ContainerEventRing : nullptr);
         string agName = thisNodeAgentNames.at(i);
-        createAgent(agName, wa, iq, oq, tq, net.thisIsCommander);
+        createAgent(agName, wa, iq, oq, tq, eq, net.thisIsCommander);
         logger.debug("Creating agent " + std::to_string(i + 1) + " of " +
                      std::to_string(numOfAgents) + " :  " + agName);
         agentsInQueue.push_back(iq);
         agentsOutQueue.push_back(oq);
         agentsTskQueue.push_back(tq);
-        agentsContainer[agName] = std::make_tuple(std::string(""), 
-                                                  int(TaskStatus(TASK_UNKNOWN_STATE)));
-
-        agentsData[agName] = agentData;
-
-        agentsNames.push_back(agName);
-        agentsTasks.push_back(0);
+        agentsEvtQueue.push_back(eq);
+        agentsEvtLost.push_back(false);
+        agentsIndex[agName] = i;
 
         AgentSpectrum sp;
         sp["ABORTED"]   = 0;
@@ -197,79 +367,184 @@ void TaskManager::createAgents()
         sp["SCHEDULED"] = 0;
         sp["STOPPED"]   = 0;
 
-        ai.agents.emplace(agName, AgentData({0, std::string(""), std::string(""), 
+        ai.agents.emplace(agName, AgentData({0, 0, std::string(""), std::string(""), 
                         TASK_UNKNOWN_STATE, sp}));
         ai.agent_names.push_back(agName);
         ai.agent_num_tasks.push_back(0);
     }
 
-    agentsInfo["agents"] = agentsData;
-    agentsInfo["agent_names"] = agentsNames;
-    agentsInfo["agent_num_tasks"] = agentsTasks;
+    agentsLoad.resize(numOfAgents);
+    agentsExec->start();
+
+    // Container life-cycle events are dispatched to the owning agents,
+    // that otherwise poll the state of their containers
+    if (agentSettings.containerEvents &&
+        (agentSettings.containerBackend != "native")) {
+        dckEvents = new DockerEventsMonitor(agentSettings.dockerSocket,
+                                            TaskAgent::QPFContainerLabel,
+                                            [this](ContainerEvent & ev) {
+                                                dispatchContainerEvent(ev); });
+        dckEvents->start();
+    }
 }
 
 //----------------------------------------------------------------------
-// Method: createTaskId
+// Method: createCollector
+// Create the node collector of exited containers, with its own
+// container manager.  Native processes are released by the agents
 //----------------------------------------------------------------------
-string TaskManager::createTaskId(string tskAgId, int n)
+void TaskManager::createCollector()
 {
-    static const char tplTaskId[] = "%s_%s-%04d";
-    char buf[200];
-    sprintf(buf, tplTaskId, tskAgId.c_str(), timeTag().c_str(), n);
-    return std::string(buf);
+    std::shared_ptr<DockerMng> mng;
+    if (agentSettings.containerBackend == "api") {
+        mng = std::make_shared<DockerApiMng>(wa, agentSettings.dockerSocket);
+    } else if (agentSettings.containerBackend != "native") {
+        mng = std::make_shared<ContainerMng>(wa);
+    } else {
+        return;
+    }
+    cntrCollector = new ContainerCollector(mng);
+    cntrCollector->start();
 }
 
 //----------------------------------------------------------------------
-// Method: createTaskFolders
+// Method: dispatchContainerEvent
+// Pass the container event to its owner agent (or to all of them, for
+// the changes in the events stream connection), and wake it up.
+// Called from the events monitor thread
 //----------------------------------------------------------------------
-void TaskManager::createTaskFolders(string & tskWkDir)
+void TaskManager::dispatchContainerEvent(ContainerEvent & ev)
 {
-    vector<string> pths ;
-    for (auto & p: {tskWkDir, tskWkDir + "/in", tskWkDir + "/out", tskWkDir + "/log"}) {
-        if (mkdir(p.c_str(), PathMode) < 0) {
-            logger.error("Couldn't create folder %s: %s",
-                         p.c_str(), strerror(errno));
+    if (ev.owner.empty()) {
+        for (int i = 0; i < numOfAgents; ++i) {
+            postContainerEvent(i, ContainerEvent(ev));
         }
-    }        
+        return;
+    }
+
+    auto it = agentsIndex.find(ev.owner);
+    if (it == agentsIndex.end()) { return; }  // Not an agent of this node
+    postContainerEvent(it->second, std::move(ev));
+}
+
+//----------------------------------------------------------------------
+// Method: postContainerEvent
+// Queues an event for an agent without ever blocking the events
+// monitor.  If the agent's ring is full the event is dropped, and a
+// "connected" event is queued as soon as there is room again, so that
+// the agent re-inspects all its containers
+//----------------------------------------------------------------------
+void TaskManager::postContainerEvent(int i, ContainerEvent && ev)
+{
+    ContainerEventRing * eq = agentsEvtQueue.at(i);
+    if (agentsEvtLost.at(i)) {
+        ContainerEvent resync {"", "connected", "", 0};
+        if (eq->tryPush(std::move(resync))) {
+            agentsEvtLost[i] = false;
+        }
+    }
+    if ((agentsEvtLost.at(i)) || (! eq->tryPush(std::move(ev)))) {
+        if (! agentsEvtLost.at(i)) {
+            logger.warn("Container events queue of agent %d is full, "
+                        "agent will resync", i);
+        }
+        agentsEvtLost[i] = true;
+    }
+    agentsExec->notify(agentsHandle.at(i));
+}
+
+//----------------------------------------------------------------------
+// Method: createOutputWatcher
+// Create the node watcher of the outputs of running tasks, if some
+// processors are set (in orchestration.streamOutputs) to hand over
+// their outputs as soon as they are written.  Outputs are complete
+// when closed, or when the processor writes a marker file for them
+//----------------------------------------------------------------------
+void TaskManager::createOutputWatcher()
+{
+    json & orc = cfg["orchestration"];
+    if (orc.count("streamOutputs") < 1) { return; }
+    json & so = orc["streamOutputs"];
+    if (so.count("processors") > 0) {
+        // Outputs of a task executed speculatively can only be taken
+        // once it finishes, and it is known to be the first copy
+        vector<string> & spec = agentSettings.speculative;
+        for (auto & p: so["processors"]) {
+            string proc = p.get<string>();
+            if (std::find(spec.begin(), spec.end(), proc) != spec.end()) {
+                logger.warn("Outputs of %s are not streamed, since it is "
+                            "executed speculatively", proc.c_str());
+                continue;
+            }
+            agentSettings.streamOutputs.push_back(proc);
+        }
+    }
+    if (agentSettings.streamOutputs.empty()) { return; }
+
+    outWatcher = new OutputWatcher(wa, outHandoff, so.value("marker", ""));
+    if (! outWatcher->start()) {
+        delete outWatcher;
+        outWatcher = nullptr;
+        agentSettings.streamOutputs.clear();
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: createTaskId
+//----------------------------------------------------------------------
+string TaskManager::createTaskId(string tskAgId, int n)
+{
+    static const char tplTaskId[] = "%s_%s-%04d";
+    char buf[200];
+    sprintf(buf, tplTaskId, tskAgId.c_str(), timeTag().c_str(), n);
+    return std::string(buf);
 }
 
 //----------------------------------------------------------------------
 // Method: createTask
-// Create task for a given product
+// Create task for a given set of products.  Returns false if the task
+// folder or any of its inputs could not be placed
 //----------------------------------------------------------------------
-std::tuple<string, string> TaskManager::createTask(ProductMeta & meta, string & tskAgId,
-                                                   int n, string & processor)
+bool TaskManager::createTask(ProductMetaList & metas, string & tskAgId, int n,
+                             string & processor, string & taskId, string & taskFld)
 {
     // Create task id. and folder
-    string taskId = createTaskId(tskAgId, n);
-    string taskFld = wa.tasks + "/" + taskId;
-    createTaskFolders(taskFld);
-    
-    // Place product in task input folder
-    ProductLocator::toTaskInput(meta, wa, taskId);
+    taskId = createTaskId(tskAgId, n);
+    taskFld = wa.tasks + "/" + taskId;
+    if (! tskFolders.acquire(taskFld)) {
+        logger.error("Cannot create folder for task %s", taskId.c_str());
+        return false;
+    }
+
+    // Place products in task input folder
+    for (auto & meta: metas) {
+        if (! ProductLocator::toTaskInput(meta, wa, taskId)) {
+            logger.error("Cannot place input %s of task %s",
+                         meta["fileinfo"]["full"].get<string>().c_str(),
+                         taskId.c_str());
+            tskFolders.release(taskFld);
+            return false;
+        }
+    }
 
     // Prepare environment for the execution of the processor
     string srcCfgProd = wa.procArea + "/" + processor + "/" + defaultProcCfg;
     string tgtCfgProd = taskFld + "/" + processor + ".cfg";
-    FileTools::copyfile(srcCfgProd, tgtCfgProd);
+    tskFolders.placeConfig(srcCfgProd, tgtCfgProd);
 
-    return std::tuple<string, string>(taskId, taskFld);
+    return true;
 }
 
 //----------------------------------------------------------------------
 // Method: selectAgent
-// Select an agent from the pool in this node as task responsible
+// Select an agent from the pool in this node as task responsible: the
+// one with less outstanding tasks (and, among them, the one that has
+// received less tasks so far)
 //----------------------------------------------------------------------
 std::tuple<int, int> TaskManager::selectAgent()
 {
-    json jNumOfTasks = agentsInfo["agent_num_tasks"];
-    int ntasks = jNumOfTasks[0].get<int>();
-    int nidx = 0;
-    for (int i = 1; i < jNumOfTasks.size(); ++i) {
-        int ntasksi = jNumOfTasks[i].get<int>();
-        if (ntasks > ntasksi) { ntasksi = ntasks, nidx = i; }
-    }
-    return std::tuple<int, int>(nidx, ntasks);
+    int nidx = agentsLoad.top();
+    return std::tuple<int, int>(nidx, ai.agent_num_tasks.at(nidx));
 }
 
 //----------------------------------------------------------------------
@@ -277,13 +552,17 @@ std::tuple<int, int> TaskManager::selectAgent()
 // Update agents information structure
 //----------------------------------------------------------------------
 void TaskManager::updateAgent(string & taskId, int agNum,
-                              string & agName, int agNumTsk)
+                              string & agName, int agNumTsk,
+                              string & processor, int attempt)
 {
-    agentsInfo["agent_num_tasks"][agNum] = agNumTsk;
-    json & agInfo = agentsInfo["agents"][agName];
-    agInfo["task_id"] = taskId;
-    agInfo["num_tasks"] = agNumTsk;
-    agentsInfo["agents"][agName] = agInfo;
+    AgentData & agData = ai.agents.at(agName);
+    agData.task_id = taskId;
+    agData.num_tasks = agNumTsk;
+    agData.pending++;
+    ai.agent_num_tasks.at(agNum) = agNumTsk;
+    activeTasks[taskId] = ActiveTask {agNum, processor, attempt, false,
+                                      std::chrono::steady_clock::now(), false};
+    agentsLoad.update(agNum, agData.pending, agNumTsk);
 }
 
 //----------------------------------------------------------------------
@@ -293,7 +572,323 @@ void TaskManager::updateAgent(string & taskId, int agNum,
 void TaskManager::updateContainer(string & agName, string contId,
                                   TaskStatus contStatus)
 {
-    agentsContainer[agName] = std::make_tuple(contId, int(contStatus));
+    AgentData & agData = ai.agents.at(agName);
+    agData.cont_id = contId;
+    agData.cont_status = contStatus;
+}
+
+//----------------------------------------------------------------------
+// Method: taskEnded
+// Remove the task from the outstanding work of its agent
+//----------------------------------------------------------------------
+void TaskManager::taskEnded(string & taskId)
+{
+    auto it = activeTasks.find(taskId);
+    if (it == activeTasks.end()) { return; }
+    int agNum = it->second.agNum;
+    activeTasks.erase(it);
+
+    AgentData & agData = ai.agents.at(ai.agent_names.at(agNum));
+    if (agData.pending > 0) { agData.pending--; }
+    agentsLoad.update(agNum, agData.pending, agData.num_tasks);
+}
+
+//----------------------------------------------------------------------
+// Method: retryHungTask
+// Schedule a new attempt of a task killed by the watchdog of its agent,
+// unless it has been retried too many times.  The decision is recorded
+// in the task information
+//----------------------------------------------------------------------
+void TaskManager::retryHungTask(TaskStatusUpdate & upd)
+{
+    auto it = activeTasks.find(upd.taskId);
+    if (it == activeTasks.end()) { return; }
+    ActiveTask & at = it->second;
+
+    // Another copy of the task may still finish
+    string origId = upd.taskId;
+    auto so = specOrigOf.find(origId);
+    if (so != specOrigOf.end()) { origId = so->second; }
+    if (speculations.count(origId) > 0) { return; }
+
+    bool retry = (at.attempt < maxTaskRetries);
+    json info = upd.inspect.empty() ? json::object() : json::parse(upd.inspect);
+    info["Watchdog"]["attempt"] = at.attempt + 1;
+    info["Watchdog"]["retry"] = retry;
+    upd.inspect = info.dump();
+
+    if (! retry) {
+        logger.error("Task %s was killed after %d attempts, giving up",
+                     upd.taskId.c_str(), at.attempt + 1);
+        return;
+    }
+
+    int delay = taskRetryDelay << std::min(at.attempt, 16);
+    logger.warn("Task %s was killed, it will be launched again in %d s",
+                upd.taskId.c_str(), delay);
+    taskRetries.emplace(std::chrono::steady_clock::now() + std::chrono::seconds(delay),
+                        TaskRetry {TaskAssignment {upd.taskId,
+                                                   wa.tasks + "/" + upd.taskId,
+                                                   at.processor},
+                                   at.agNum, at.attempt + 1});
+}
+
+//----------------------------------------------------------------------
+// Method: dispatchRetries
+// Send the tasks to be retried, once their delay expired, to the least
+// loaded agent other than the one where they hung
+//----------------------------------------------------------------------
+void TaskManager::dispatchRetries()
+{
+    auto now = std::chrono::steady_clock::now();
+    while ((! taskRetries.empty()) && (taskRetries.begin()->first <= now)) {
+        TaskRetry r = std::move(taskRetries.begin()->second);
+        taskRetries.erase(taskRetries.begin());
+
+        int agNum = std::get<0>(selectAgent());
+        if ((agNum == r.lastAgNum) && (numOfAgents > 1)) {
+            agNum = -1;
+            for (int i = 0; i < numOfAgents; ++i) {
+                if (i == r.lastAgNum) { continue; }
+                if ((agNum < 0) ||
+                    (ai.agents.at(ai.agent_names.at(i)).pending <
+                     ai.agents.at(ai.agent_names.at(agNum)).pending)) {
+                    agNum = i;
+                }
+            }
+        }
+        string agName = ai.agent_names.at(agNum);
+        int numTasks = ai.agent_num_tasks.at(agNum) + 1;
+
+        logger.info("Launching again task %s (attempt %d) in agent %s",
+                    r.task.taskId.c_str(), r.attempt + 1, agName.c_str());
+        string taskId(r.task.taskId);
+        string processor(r.task.processor);
+        agentsInQueue.at(agNum)->push(std::move(r.task));
+        agentsExec->notify(agentsHandle.at(agNum));
+        updateAgent(taskId, agNum, agName, numTasks, processor, r.attempt);
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: trackTaskRun
+// Keep the time each task started running, and the run times of the
+// finished tasks of the processors executed speculatively
+//----------------------------------------------------------------------
+void TaskManager::trackTaskRun(TaskStatusUpdate & upd)
+{
+    auto it = activeTasks.find(upd.taskId);
+    if (it == activeTasks.end()) { return; }
+    ActiveTask & at = it->second;
+    TaskStatus status(upd.status);
+    auto now = std::chrono::steady_clock::now();
+
+    if ((upd.status == TASK_RUNNING) && (! at.running)) {
+        at.running = true;
+        at.started = now;
+        return;
+    }
+    if ((! status.isEnded()) || agentSettings.speculative.empty()) { return; }
+
+    vector<string> & spec = agentSettings.speculative;
+    if ((upd.status == TASK_FINISHED) && at.running &&
+        (std::find(spec.begin(), spec.end(), at.processor) != spec.end())) {
+        std::deque<double> & rt = procRuntimes[at.processor];
+        rt.push_back(std::chrono::duration<double>(now - at.started).count());
+        if (rt.size() > MaxRuntimeSamples) { rt.pop_front(); }
+    }
+    settleSpeculation(upd.taskId, upd.status == TASK_FINISHED);
+}
+
+//----------------------------------------------------------------------
+// Method: settleSpeculation
+// Once a copy of a task executed speculatively finishes, the other one
+// is cancelled.  The task is forgotten when both copies ended
+//----------------------------------------------------------------------
+void TaskManager::settleSpeculation(string & taskId, bool finished)
+{
+    string origId = taskId;
+    auto so = specOrigOf.find(taskId);
+    if (so != specOrigOf.end()) { origId = so->second; }
+
+    auto it = speculations.find(origId);
+    if (it == speculations.end()) {
+        taskClaims.release(taskId);
+        return;
+    }
+    Speculation & sp = it->second;
+    bool isDup = (taskId != origId);
+    if (isDup) { sp.dupEnded = true; } else { sp.origEnded = true; }
+
+    if (finished) {
+        string other = isDup ? origId : sp.dupId;
+        if (! (isDup ? sp.origEnded : sp.dupEnded)) {
+            logger.info("Task %s finished first, cancelling %s",
+                        taskId.c_str(), other.c_str());
+            cancelTask(other);
+        }
+    }
+
+    if (sp.origEnded && sp.dupEnded) {
+        taskClaims.release(origId);
+        specOrigOf.erase(sp.dupId);
+        speculations.erase(it);
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: speculate
+// Launch a copy of the running tasks that take longer than the
+// configured percentile of the run times of their processors, in an
+// idle agent other than the one running them
+//----------------------------------------------------------------------
+void TaskManager::speculate()
+{
+    if (agentSettings.speculative.empty() || (numOfAgents < 2)) { return; }
+
+    auto now = std::chrono::steady_clock::now();
+    map<string, double> threshold;
+    vector<std::pair<string, int>> stragglers;
+
+    for (auto & kv: activeTasks) {
+        ActiveTask & at = kv.second;
+        if ((! at.running) || at.specFailed ||
+            (speculations.count(kv.first) > 0) ||
+            (specOrigOf.count(kv.first) > 0)) { continue; }
+
+        auto th = threshold.find(at.processor);
+        if (th == threshold.end()) {
+            double limit = -1.;
+            auto rt = procRuntimes.find(at.processor);
+            if ((rt != procRuntimes.end()) &&
+                ((int)(rt->second.size()) >= specMinSamples)) {
+                vector<double> times(rt->second.begin(), rt->second.end());
+                size_t k = (times.size() * specPercentile) / 100;
+                k = std::min(k, times.size() - 1);
+                std::nth_element(times.begin(), times.begin() + k, times.end());
+                limit = times.at(k);
+            }
+            th = threshold.emplace(at.processor, limit).first;
+        }
+        if ((th->second < 0.) ||
+            (std::chrono::duration<double>(now - at.started).count() <= th->second)) {
+            continue;
+        }
+        stragglers.push_back(std::make_pair(kv.first, at.agNum));
+    }
+
+    for (auto & s: stragglers) {
+        int agNum = -1;
+        for (int i = 0; i < numOfAgents; ++i) {
+            if ((i != s.second) &&
+                (ai.agents.at(ai.agent_names.at(i)).pending == 0)) {
+                agNum = i;
+                break;
+            }
+        }
+        if (agNum < 0) { return; }
+        (void)duplicateTask(s.first, agNum);
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: duplicateTask
+// Create a copy of a task, with the same inputs and configuration, and
+// send it to the given agent
+//----------------------------------------------------------------------
+bool TaskManager::duplicateTask(string origId, int agNum)
+{
+    // The task may have just finished
+    if (! taskClaims.open(origId)) { return false; }
+
+    ActiveTask & at = activeTasks.at(origId);
+    string processor(at.processor);
+    int attempt = at.attempt;
+
+    string dupId = origId + "-spec";
+    if (attempt > 0) { dupId += std::to_string(attempt); }
+    string origFld = wa.tasks + "/" + origId;
+    string dupFld = wa.tasks + "/" + dupId;
+    // A task that cannot be copied is not tried again
+    if (! tskFolders.acquire(dupFld)) {
+        logger.warn("Cannot create the folder for a copy of task %s",
+                    origId.c_str());
+        at.specFailed = true;
+        return false;
+    }
+    if (! linkTaskInputs(origFld, dupFld)) {
+        logger.warn("Cannot place the inputs of task %s for a copy of it",
+                    origId.c_str());
+        tskFolders.release(dupFld);
+        at.specFailed = true;
+        return false;
+    }
+    // The copy shares the configuration of the original task, that is
+    // not a template and so is not kept in the pool
+    string srcCfgProd = origFld + "/" + processor + ".cfg";
+    string tgtCfgProd = dupFld + "/" + processor + ".cfg";
+    if (link(srcCfgProd.c_str(), tgtCfgProd.c_str()) != 0) {
+        string tplCfgProd = wa.procArea + "/" + processor + "/" + defaultProcCfg;
+        if (! tskFolders.placeConfig(tplCfgProd, tgtCfgProd)) {
+            logger.warn("Cannot place the configuration of task %s for a "
+                        "copy of it", origId.c_str());
+            tskFolders.release(dupFld);
+            at.specFailed = true;
+            return false;
+        }
+    }
+
+    string agName = ai.agent_names.at(agNum);
+    int numTasks = ai.agent_num_tasks.at(agNum) + 1;
+    logger.info("Task %s is a straggler, launching a copy %s in agent %s",
+                origId.c_str(), dupId.c_str(), agName.c_str());
+
+    agentsInQueue.at(agNum)->push(TaskAssignment {dupId, dupFld, processor,
+                                                   origId, false});
+    agentsExec->notify(agentsHandle.at(agNum));
+    updateAgent(dupId, agNum, agName, numTasks, processor, attempt);
+
+    speculations[origId] = Speculation {dupId, false, false};
+    specOrigOf[dupId] = origId;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: linkTaskInputs
+// Place in the input folder of the copy of a task hard links to the
+// inputs of the original one
+//----------------------------------------------------------------------
+bool TaskManager::linkTaskInputs(string & origFld, string & dupFld)
+{
+    string origIn = origFld + "/in";
+    string dupIn = dupFld + "/in";
+    DIR * dir = opendir(origIn.c_str());
+    if (dir == nullptr) { return false; }
+
+    bool ok = true;
+    struct dirent * ent;
+    while (ok && ((ent = readdir(dir)) != nullptr)) {
+        string name(ent->d_name);
+        string src = origIn + "/" + name;
+        struct stat st;
+        if ((stat(src.c_str(), &st) != 0) || (! S_ISREG(st.st_mode))) { continue; }
+        ok = (link(src.c_str(), (dupIn + "/" + name).c_str()) == 0);
+    }
+    closedir(dir);
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// Method: cancelTask
+// Withdraw a task from the agent it was sent to
+//----------------------------------------------------------------------
+void TaskManager::cancelTask(string & taskId)
+{
+    auto it = activeTasks.find(taskId);
+    if (it == activeTasks.end()) { return; }
+    int agNum = it->second.agNum;
+    agentsInQueue.at(agNum)->push(TaskAssignment {taskId, "", "", "", true});
+    agentsExec->notify(agentsHandle.at(agNum));
 }
 
 //----------------------------------------------------------------------
@@ -302,56 +897,75 @@ void TaskManager::updateContainer(string & agName, string contId,
 //----------------------------------------------------------------------
 void TaskManager::updateTasksInfo()
 {
+    bool updated = false;
     int numOfAgents = net.thisNodeNumOfAgents;
     for (int agNum = 0; agNum < numOfAgents; ++agNum) {
-        Queue<string> * tq = agentsTskQueue.at(agNum);
-        string agName = agentsInfo["agent_names"][agNum];
-        string justCreated, taskId, contId, inspect, percent, status;
-        while (tq->get(justCreated)) {
-            tq->get(taskId);
-            tq->get(contId);
-            tq->get(inspect);
-            tq->get(percent);
-            tq->get(status);
-            int statusVal = TaskStatusVal[status];
-            updateContainer(agName, contId, statusVal);
-            if (inspect.empty()) { inspect = "{}"; }
+        TaskStatusUpdateRing * tq = agentsTskQueue.at(agNum);
+        string & agName = ai.agent_names.at(agNum);
+        TaskStatusUpdate upd;
+        while (tq->tryPop(upd)) {
+            updated = true;
+            TaskStatus status(upd.status);
+            updateContainer(agName, upd.contId, status);
+            trackTaskRun(upd);
+            if (upd.hung) { retryHungTask(upd); }
+            if (status.isEnded()) { taskEnded(upd.taskId); }
+            if (upd.inspect.empty()) { upd.inspect = "{}"; }
             
             agentTaskInfo[agName] = "{" +
-                ("\"task_id\": \"" + taskId + "\"," +
-                 "\"status\": \"" + status + "\"," +
-                 "\"info\": " + inspect + "," +
-                 "\"new\": " + justCreated) + "}";
+                ("\"task_id\": \"" + upd.taskId + "\"," +
+                 "\"status\": \"" + status.str() + "\"," +
+                 "\"info\": " + upd.inspect + "," +
+                 "\"new\": " + (upd.justCreated ? "true" : "false")) + "}";
             // datmng.storeTaskInfo(taskId, statusVal,
             //                      inspect, justCreated == "true");
         }
     }
+
+    if (updated) { taskInfoSnapshot.publish(serializeTaskInfo()); }
+
+    dispatchRetries();
+    speculate();
 }
 
 //----------------------------------------------------------------------
 // Method: schedule
 // Prepare task and send to selected agent
 //----------------------------------------------------------------------
-void TaskManager::schedule(ProductMeta & meta, string & processor)
+bool TaskManager::schedule(ProductMeta & meta, string & processor)
+{
+    ProductMetaList metas {meta};
+    if (! schedule(metas, processor)) { return false; }
+    meta = metas.front();
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: schedule
+// Prepare task for a group of products and send to selected agent.
+// Returns false if the task could not be prepared
+//----------------------------------------------------------------------
+bool TaskManager::schedule(ProductMetaList & metas, string & processor)
 {
     int agNum, numTasks;
     std::tie<int, int>(agNum, numTasks) = selectAgent();
-    string agName = agentsInfo["agent_names"][agNum].get<std::string>();
+    string agName = ai.agent_names.at(agNum);
     numTasks++;
 
     // Create task id and environment
     string taskId, taskFolder;
-    std::tie<string, string>(taskId, taskFolder) =
-        createTask(meta, agName, numTasks, processor);
+    if (! createTask(metas, agName, numTasks, processor, taskId, taskFolder)) {
+        return false;
+    }
 
     // Pass task id to selected agent
-    Queue<string> * iq = agentsInQueue.at(agNum);
-    iq->push(std::move(std::string(taskId)));
-    iq->push(std::move(std::string(taskFolder)));
-    iq->push(std::move(processor));
+    agentsInQueue.at(agNum)->push(TaskAssignment {taskId, taskFolder,
+                                                   processor});
+    agentsExec->notify(agentsHandle.at(agNum));
 
     // Update agents information structures
-    updateAgent(taskId, agNum, agName, numTasks);
+    updateAgent(taskId, agNum, agName, numTasks, processor);
+    return true;
 }
 
 //----------------------------------------------------------------------
@@ -370,6 +984,28 @@ void TaskManager::retrieveOutputs(Queue<string> & outputs)
     }
 }
 
+//----------------------------------------------------------------------
+// Method: retrieveHandedOutputs
+// Returns the outputs handed over directly by the agents
+//----------------------------------------------------------------------
+bool TaskManager::retrieveHandedOutputs(vector<HandedOutput> & outputs)
+{
+    return (outHandoff != nullptr) && outHandoff->retrieve(outputs);
+}
+
+//----------------------------------------------------------------------
+// Method: waitForHandedOutputs
+// Waits until some output is handed over, or the deadline
+//----------------------------------------------------------------------
+bool TaskManager::waitForHandedOutputs(std::chrono::steady_clock::time_point deadline)
+{
+    if (outHandoff == nullptr) {
+        std::this_thread::sleep_until(deadline);
+        return false;
+    }
+    return outHandoff->waitUntil(deadline);
+}
+
 //----------------------------------------------------------------------
 // Method: retrieveAgentsInfo
 //----------------------------------------------------------------------
@@ -379,44 +1015,53 @@ bool TaskManager::retrieveAgentsInfo(json & hi)
     
     for (int agNum = 0; agNum < numOfAgents; ++agNum) {
         string serialAgName = nodeAgNames.at(agNum);
-        Queue<string> * oq = agentsOutQueue.at(agNum);
-        string agName;
-        string msg;
-        while (oq->get(agName)) {
-            oq->get(msg);
-            json & ags = agentsInfo["agents"];
-            json & agThis = ags[agName];
-            for (auto & el: str::split(msg, ' ')) {
-                vector<string> parts = str::split(el, ':');
-                agThis["spectrum"][parts.at(0)] = std::stoi(parts.at(1));
-            }
+        SpectrumUpdateRing * oq = agentsOutQueue.at(agNum);
+        SpectrumUpdate msg;
+        bool updated = false;
+        while (oq->tryPop(msg)) { updated = true; }
+        if (! updated) { continue; }
+
+        // Only the last spectrum received is relevant
+        AgentSpectrum & spectrum = ai.agents.at(serialAgName).spectrum;
+        for (auto & kv: spectrum) {
+            auto it = TaskStatusVal.find(kv.first);
+            if (it == TaskStatusVal.end()) { continue; }
+            kv.second = msg.counts[SpectrumUpdate::index(it->second)];
         }
     }
 
-    vector<double> loadavgs = getLoadAvgs();
-    json loads(loadavgs);
-
-    std::stringstream ss;
-    std::ifstream fProcVersion("/proc/version");
-    ss << fProcVersion.rdbuf();
-    fProcVersion.close();
-    string hostNameVersion = ss.str();
-    hostNameVersion.pop_back();
+    HostTelemetry t = hostMon.get();
 
     json machineInfo;
-    machineInfo["load"] = loads;
-    machineInfo["uname"] = hostNameVersion;
-
-    agentsInfo["machine"] = machineInfo;
+    machineInfo["load"] = {t.load[0], t.load[1], t.load[2]};
+    machineInfo["cpu"] = t.cpuPct;
+    machineInfo["cpus"] = hostMon.numOfCpus();
+    machineInfo["mem"] = {{"total", t.memTotal},
+                          {"available", t.memAvailable}};
+    machineInfo["disk"] = {{"total", t.diskTotal},
+                           {"free", t.diskFree}};
+    machineInfo["uname"] = hostMon.uname();
+    machineInfo["copies"] = CopyEngine::metrics();
 
-    hi = agentsInfo;
+    hi = json::parse(ai.str());
+    hi["machine"] = machineInfo;
     return true;
 }
 
 //----------------------------------------------------------------------
 // Method: getTaskInfo
+// Returns the last snapshot of the tasks information published by
+// updateTasksInfo.  Safe to be called from other threads
+//----------------------------------------------------------------------
+SnapshotPtr TaskManager::getTaskInfo()
+{
+    return taskInfoSnapshot.get();
+}
+
+//----------------------------------------------------------------------
+// Method: serializeTaskInfo
 //----------------------------------------------------------------------
-string TaskManager::getTaskInfo()
+string TaskManager::serializeTaskInfo()
 {
     string ret_taskInfo("{");
     for (const auto & kv : agentTaskInfo) {
@@ -433,9 +1078,8 @@ void TaskManager::showSpectra()
 {
     int numOfAgents = net.thisNodeNumOfAgents;
     for (int agNum = 0; agNum < numOfAgents; ++agNum) {
-        string agName = agentsInfo["agent_names"][agNum];
-        json & agInfo = agentsInfo["agents"][agName];
-        string spectrum = agInfo["spectrum"].dump();
+        string & agName = ai.agent_names.at(agNum);
+        string spectrum = agentSpectrumToStr(ai.agents.at(agName).spectrum);
         logger.debug("Agent %d of %d - %s: %s", agNum + 1, numOfAgents,
                      agName.c_str(), spectrum.c_str());
     }
@@ -446,6 +1090,30 @@ void TaskManager::showSpectra()
 //----------------------------------------------------------------------
 void TaskManager::terminate()
 {
-    for (auto & thr : agentThreads) { thr.join(); }
+    if (dckEvents != nullptr) {
+        dckEvents->stop();
+        delete dckEvents;
+        dckEvents = nullptr;
+    }
+    if (agentsExec != nullptr) {
+        agentsExec->stop();
+        delete agentsExec;
+        agentsExec = nullptr;
+    }
+    if (cntrCollector != nullptr) {
+        cntrCollector->stop();
+        delete cntrCollector;
+        cntrCollector = nullptr;
+    }
+    if (outWatcher != nullptr) {
+        outWatcher->stop();
+        delete outWatcher;
+        outWatcher = nullptr;
+    }
+    if (outHandoff != nullptr) {
+        delete outHandoff;
+        outHandoff = nullptr;
+    }
 }
 
+const size_t TaskManager::MaxRuntimeSamples = 100;
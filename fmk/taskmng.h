@@ -51,6 +51,7 @@
 //------------------------------------------------------------
 #include <iostream>
 #include <tuple>
+#include <deque>
 
 //------------------------------------------------------------
 // Topic: External packages
@@ -63,6 +64,17 @@
 #include "types.h"
 #include "wa.h"
 #include "procnet.h"
+#include "idxheap.h"
+#include "agentmsg.h"
+#include "snapshot.h"
+#include "hostmon.h"
+#include "tskpool.h"
+#include "agentexec.h"
+#include "dckevents.h"
+#include "cntrgc.h"
+#include "cpuinv.h"
+#include "outwatch.h"
+#include "taskclaims.h"
 #include "log.h"
 #include "q.h"
 
@@ -98,7 +110,7 @@ public:
     //----------------------------------------------------------------------
     // Method: getTaskInfo
     //----------------------------------------------------------------------
-    string getTaskInfo();
+    SnapshotPtr getTaskInfo();
     
     //----------------------------------------------------------------------
     // Method: showSpectra
@@ -110,6 +122,18 @@ public:
     //----------------------------------------------------------------------
     void retrieveOutputs(Queue<string> & outputs);
 
+    //----------------------------------------------------------------------
+    // Method: retrieveHandedOutputs
+    // Returns the outputs handed over directly by the agents
+    //----------------------------------------------------------------------
+    bool retrieveHandedOutputs(vector<HandedOutput> & outputs);
+
+    //----------------------------------------------------------------------
+    // Method: waitForHandedOutputs
+    // Waits until some output is handed over, or the deadline
+    //----------------------------------------------------------------------
+    bool waitForHandedOutputs(std::chrono::steady_clock::time_point deadline);
+
     //----------------------------------------------------------------------
     // Method: updateTasksInfo
     //----------------------------------------------------------------------
@@ -118,11 +142,37 @@ public:
     //----------------------------------------------------------------------
     // Method: schedule
     //----------------------------------------------------------------------
-    void schedule(ProductMeta & meta, string & processor);
+    bool schedule(ProductMeta & meta, string & processor);
+
+    //----------------------------------------------------------------------
+    // Method: schedule
+    // Schedule one task to process a group of products
+    //----------------------------------------------------------------------
+    bool schedule(ProductMetaList & metas, string & processor);
 
 protected:
 
 private:
+    //----------------------------------------------------------------------
+    // Method: setAgentSettings
+    //----------------------------------------------------------------------
+    void setAgentSettings();
+
+    //----------------------------------------------------------------------
+    // Method: setCpuPinning
+    //----------------------------------------------------------------------
+    void setCpuPinning();
+
+    //----------------------------------------------------------------------
+    // Method: setTaskWatchdog
+    //----------------------------------------------------------------------
+    void setTaskWatchdog();
+
+    //----------------------------------------------------------------------
+    // Method: setSpeculation
+    //----------------------------------------------------------------------
+    void setSpeculation();
+
     //----------------------------------------------------------------------
     // Method: setDirectoryWatchers
     //----------------------------------------------------------------------
@@ -142,24 +192,40 @@ private:
     // Method: createAgents
     //----------------------------------------------------------------------
     void createAgent(string id, WorkArea wa,
-                     Queue<string> * iq, Queue<string> * oq, Queue<string> * tq,
+                     TaskAssignmentRing * iq, SpectrumUpdateRing * oq,
+                     TaskStatusUpdateRing * tq, ContainerEventRing * eq,
                      bool isComm);
-    
+
     //----------------------------------------------------------------------
-    // Method: createTaskId
+    // Method: createCollector
     //----------------------------------------------------------------------
-    string createTaskId(string tskAgId, int n);
+    void createCollector();
+
+    //----------------------------------------------------------------------
+    // Method: createOutputWatcher
+    //----------------------------------------------------------------------
+    void createOutputWatcher();
 
     //----------------------------------------------------------------------
-    // Method: createTaskFolders
+    // Method: dispatchContainerEvent
     //----------------------------------------------------------------------
-    void createTaskFolders(string & tskWkDir);
+    void dispatchContainerEvent(ContainerEvent & ev);
+
+    //----------------------------------------------------------------------
+    // Method: postContainerEvent
+    //----------------------------------------------------------------------
+    void postContainerEvent(int i, ContainerEvent && ev);
+    
+    //----------------------------------------------------------------------
+    // Method: createTaskId
+    //----------------------------------------------------------------------
+    string createTaskId(string tskAgId, int n);
 
     //----------------------------------------------------------------------
     // Method: createTask
     //----------------------------------------------------------------------
-    std::tuple<string, string> createTask(ProductMeta & meta, string & tskAgId,
-                                          int n, string & processor);
+    bool createTask(ProductMetaList & metas, string & tskAgId, int n,
+                    string & processor, string & taskId, string & taskFld);
 
     //----------------------------------------------------------------------
     // Method: selectAgent
@@ -169,7 +235,8 @@ private:
     //----------------------------------------------------------------------
     // Method: updateAgent
     //----------------------------------------------------------------------
-    void updateAgent(string & taskId, int agNum, string & agName, int agNumTsk);
+    void updateAgent(string & taskId, int agNum, string & agName, int agNumTsk,
+                     string & processor, int attempt = 0);
 
     //----------------------------------------------------------------------
     // Method: updateContainer
@@ -177,6 +244,56 @@ private:
     void updateContainer(string & agName, string contId = string(""),
                          TaskStatus contStatus = TaskStatus(TASK_SCHEDULED));
 
+    //----------------------------------------------------------------------
+    // Method: serializeTaskInfo
+    //----------------------------------------------------------------------
+    string serializeTaskInfo();
+
+    //----------------------------------------------------------------------
+    // Method: taskEnded
+    //----------------------------------------------------------------------
+    void taskEnded(string & taskId);
+
+    //----------------------------------------------------------------------
+    // Method: retryHungTask
+    //----------------------------------------------------------------------
+    void retryHungTask(TaskStatusUpdate & upd);
+
+    //----------------------------------------------------------------------
+    // Method: dispatchRetries
+    //----------------------------------------------------------------------
+    void dispatchRetries();
+
+    //----------------------------------------------------------------------
+    // Method: trackTaskRun
+    //----------------------------------------------------------------------
+    void trackTaskRun(TaskStatusUpdate & upd);
+
+    //----------------------------------------------------------------------
+    // Method: settleSpeculation
+    //----------------------------------------------------------------------
+    void settleSpeculation(string & taskId, bool finished);
+
+    //----------------------------------------------------------------------
+    // Method: speculate
+    //----------------------------------------------------------------------
+    void speculate();
+
+    //----------------------------------------------------------------------
+    // Method: duplicateTask
+    //----------------------------------------------------------------------
+    bool duplicateTask(string origId, int agNum);
+
+    //----------------------------------------------------------------------
+    // Method: linkTaskInputs
+    //----------------------------------------------------------------------
+    bool linkTaskInputs(string & origFld, string & dupFld);
+
+    //----------------------------------------------------------------------
+    // Method: cancelTask
+    //----------------------------------------------------------------------
+    void cancelTask(string & taskId);
+
     //----------------------------------------------------------------------
     // Method: terminate
     //----------------------------------------------------------------------
@@ -191,28 +308,77 @@ private:
     int thisNodeNum;
     int numOfAgents;
     double agentsHeartBeat;
+    AgentSettings agentSettings;
+    vector<CpuSlot> agentsCpuSlots;
 
     Queue<string> outboxProdQueue;
     vector<DirWatchedAndQueue> dirWatchers;
 
     vector<TaskAgent*> agents;
-    vector<std::thread> agentThreads;
+    AgentExecutor * agentsExec;
+    vector<int> agentsHandle;
 
-    vector<Queue<string>*> agentsInQueue;
-    vector<Queue<string>*> agentsOutQueue;
-    vector<Queue<string>*> agentsTskQueue;
+    vector<TaskAssignmentRing*>   agentsInQueue;
+    vector<SpectrumUpdateRing*>   agentsOutQueue;
+    vector<TaskStatusUpdateRing*> agentsTskQueue;
+    vector<ContainerEventRing*>   agentsEvtQueue;
+    vector<bool>                  agentsEvtLost;
+    map<string, int>              agentsIndex;
+
+    DockerEventsMonitor * dckEvents;
+    ContainerCollector * cntrCollector;
+    OutputWatcher * outWatcher;
+    OutputHandoff * outHandoff;
 
     map<string, string> agentTaskInfo;
-    
-    map<string, std::tuple<string, int>> agentsContainer;
-        
-    json agentsInfo;
+    SnapshotPublisher taskInfoSnapshot;
 
     AgentsInfo ai;
+    IndexedMinHeap agentsLoad;
+    // Agent, processor and attempt number of each outstanding task, and
+    // the time it started running
+    struct ActiveTask {
+        int    agNum;
+        string processor;
+        int    attempt;
+        bool   running;
+        std::chrono::steady_clock::time_point started;
+        bool   specFailed;
+    };
+    map<string, ActiveTask> activeTasks;
+
+    // Tasks killed by the agents watchdog, to be launched again
+    struct TaskRetry {
+        TaskAssignment task;
+        int            lastAgNum;
+        int            attempt;
+    };
+    std::multimap<std::chrono::steady_clock::time_point, TaskRetry> taskRetries;
+    int maxTaskRetries;
+    int taskRetryDelay;
+
+    // Speculative copies of straggler tasks, by original task id, and
+    // the recent run times of the processors executed speculatively
+    struct Speculation {
+        string dupId;
+        bool   origEnded;
+        bool   dupEnded;
+    };
+    map<string, Speculation> speculations;
+    map<string, string> specOrigOf;
+    map<string, std::deque<double>> procRuntimes;
+    int specPercentile;
+    int specMinSamples;
+    TaskClaims taskClaims;
 
     string defaultProcCfg;
+
+    HostMonitor hostMon;
+    TaskFolderPool tskFolders;
     
     Logger logger;
+
+    static const size_t MaxRuntimeSamples;
 };
 
 #endif // TASKMANAGER_H
@@ -39,20 +39,89 @@
  ******************************************************************************/
 
 #include "taskorc.h"
+#include "prodloc.h"
+#include "str.h"
+
+#include <algorithm>
+
+#include <unistd.h>
+
+// Longest delay (s) between attempts to fire a group
+static const int MaxGroupRetryDelay = 300;
 
 //----------------------------------------------------------------------
 // Constructor
 //----------------------------------------------------------------------
 TaskOrchestrator::TaskOrchestrator(Config & _cfg, string _id)
-    : cfg(_cfg), id(_id),
+    : cfg(_cfg), id(_id), grouped(false),
       logger(Log::getLogger("tskorc"))
 {
     workArea = cfg["general"]["workArea"];
+
+    // Products waiting for a group rule are kept (linked) here
+    joinArea = workArea + "/run/joins";
+    if ((mkdir(joinArea.c_str(), PathMode) < 0) && (errno != EEXIST)) {
+        logger.error("Couldn't create folder %s: %s",
+                     joinArea.c_str(), strerror(errno));
+    }
+
     json & jrules = cfg["orchestration"]["rules"];
     for (auto & r: jrules) {
         string rname(r["name"]);
         rules[rname] = map<string, string>({{"inputs", r["inputs"]},
                                             {"processing", r["processing"]}});
+
+        // Compile rule condition, to be evaluated for each product.  It
+        // may also be given as a number or a boolean
+        json jcond = r.value("condition", json("1"));
+        string cond;
+        if (jcond.is_string()) {
+            cond = jcond.get<string>();
+        } else if (jcond.is_boolean()) {
+            cond = jcond.get<bool>() ? "true" : "false";
+        } else if (jcond.is_number()) {
+            cond = jcond.dump();
+        } else if (jcond.is_null()) {
+            cond = "1";
+        } else {
+            logger.error("Condition of rule %s is not an expression",
+                         rname.c_str());
+            cond = "false";
+        }
+        RuleCondition & rc = conditions[rname];
+        if (! rc.compile(cond)) {
+            logger.error("Rule %s will never fire: %s",
+                         rname.c_str(), rc.error().c_str());
+        } else if (! rc.isTrivial()) {
+            logger.debug("Rule %s has condition: %s",
+                         rname.c_str(), cond.c_str());
+        }
+
+        // Group rules (join, count, window) accumulate products
+        string type = r.value("type", std::string("single"));
+        if (type == "single") { continue; }
+        if ((type != "join") && (type != "count") && (type != "window")) {
+            logger.error("Unknown type '%s' for rule %s, ignored",
+                         type.c_str(), rname.c_str());
+            rules.erase(rname);
+            continue;
+        }
+        GroupSpec spec({type, r.value("groupBy", std::string("obs_id")),
+                        str::split(r["inputs"].get<string>(), ','),
+                        r.value("count", 0), r.value("window", 0)});
+        if (((type == "count") && (spec.count < 1)) ||
+            ((type == "window") && (spec.window < 1))) {
+            logger.error("Rule %s of type %s needs a positive '%s' value",
+                         rname.c_str(), type.c_str(), type.c_str());
+            rules.erase(rname);
+            continue;
+        }
+        groupRules[rname] = spec;
+        string ruleArea = joinArea + "/" + rname;
+        if ((mkdir(ruleArea.c_str(), PathMode) < 0) && (errno != EEXIST)) {
+            logger.error("Couldn't create folder %s: %s",
+                         ruleArea.c_str(), strerror(errno));
+        }
     }
 
     json & jprocs =  cfg["orchestration"]["processors"];
@@ -62,6 +131,8 @@ TaskOrchestrator::TaskOrchestrator(Config & _cfg, string _id)
         processors[k] = v;
         logger.debug("Storing proc.: %s => %s", k.c_str(), v.c_str());
     }
+
+    joins = new JoinTable(joinArea + "/joins.jnl");
 }
 
 //----------------------------------------------------------------------
@@ -69,6 +140,149 @@ TaskOrchestrator::TaskOrchestrator(Config & _cfg, string _id)
 //----------------------------------------------------------------------
 TaskOrchestrator::~TaskOrchestrator()
 {
+    delete joins;
+}
+
+//----------------------------------------------------------------------
+// Method: accumulate
+// Adds the product to the group of a join/count/window rule, and
+// returns true if the group now holds it.  The ready flag tells if
+// the group can be fired
+//----------------------------------------------------------------------
+bool TaskOrchestrator::accumulate(string const & rname, ProductMeta & prod,
+                                  string & key, bool & ready)
+{
+    ready = false;
+
+    GroupSpec & spec = groupRules[rname];
+    auto kit = prod.find(spec.groupBy);
+    if ((kit == prod.end()) || kit->is_null()) {
+        logger.warn("Product %s has no %s, cannot be used in rule %s",
+                    prod["fileinfo"]["base"].get<std::string>().c_str(),
+                    spec.groupBy.c_str(), rname.c_str());
+        return false;
+    }
+    // Numbers, booleans, etc. are grouped by their JSON text
+    key = kit->is_string() ? kit->get<string>() : kit->dump();
+
+    // Keep a link to the product, so that it is available when the
+    // rule fires, and store it in the group
+    ProductMeta m(prod);
+    string from = m["fileinfo"]["full"];
+    string path = joinArea + "/" + rname;
+    string to = path + "/" + m["fileinfo"]["base"].get<string>();
+    struct stat buffer;
+    if (stat(to.c_str(), &buffer) == 0) {
+        logger.debug("Product %s already in group %s of rule %s",
+                     to.c_str(), key.c_str(), rname.c_str());
+        return false;
+    }
+    if (ProductLocator::relocate(from, to, ProductLocator::LINK) != 0) {
+        return false;
+    }
+    m["fileinfo"]["full"] = to;
+    m["fileinfo"]["path"] = path;
+
+    if (joins->add(rname, key, m)) {
+        logger.info("Product %s added to group %s of rule %s",
+                    m["fileinfo"]["base"].get<std::string>().c_str(),
+                    key.c_str(), rname.c_str());
+    }
+
+    ready = isGroupReady(rname, *(joins->find(rname, key)), time(nullptr));
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: isGroupReady
+// A group is ready when all the inputs are there (join), when the
+// requested number of products is reached (count), or when the time
+// window has expired (window)
+//----------------------------------------------------------------------
+bool TaskOrchestrator::isGroupReady(string const & rname,
+                                    JoinTable::Group & grp, time_t now)
+{
+    GroupSpec & spec = groupRules[rname];
+
+    if ((spec.count > 0) && (grp.prods.size() >= spec.count)) { return true; }
+    if ((spec.window > 0) && ((now - grp.firstSeen) >= spec.window)) { return true; }
+
+    if (spec.type == "join") {
+        for (auto & t: spec.inputs) {
+            bool found = false;
+            for (auto & m: grp.prods) {
+                if (m["type"] == t) { found = true; break; }
+            }
+            if (! found) { return false; }
+        }
+        return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------
+// Method: fireGroup
+// Schedules one task with all the products of the group.  If the task
+// cannot be prepared, the group is kept to be fired again after a
+// growing delay, unless some of its products are gone
+//----------------------------------------------------------------------
+bool TaskOrchestrator::fireGroup(string const & rname, string const & key,
+                                 TaskManager & manager)
+{
+    JoinTable::Group * grp = joins->find(rname, key);
+    if (grp == nullptr) { return false; }
+
+    string gid = JoinTable::groupId(rname, key);
+    time_t now = time(nullptr);
+    auto rit = groupRetries.find(gid);
+    if ((rit != groupRetries.end()) && (now < rit->second.next)) { return false; }
+
+    string processor = processors[rules[rname]["processing"]];
+    logger.info("Rule %s fired by group %s (%d products)",
+                rname.c_str(), key.c_str(), (int)(grp->prods.size()));
+
+    vector<string> staged;
+    for (auto & m: grp->prods) { staged.push_back(m["fileinfo"]["full"]); }
+
+    ProductMetaList prods(grp->prods);
+    if (! manager.schedule(prods, processor)) {
+        struct stat buffer;
+        for (auto & f: staged) {
+            if (stat(f.c_str(), &buffer) == 0) { continue; }
+            logger.error("Product %s of group %s of rule %s is gone, "
+                         "the group is discarded",
+                         f.c_str(), key.c_str(), rname.c_str());
+            discardGroup(rname, key);
+            return false;
+        }
+        GroupRetry & rt = groupRetries[gid];
+        rt.delay = std::min(std::max(2 * rt.delay, 1), MaxGroupRetryDelay);
+        rt.next = now + rt.delay;
+        logger.error("Couldn't schedule group %s of rule %s, "
+                     "retrying in %d s", key.c_str(), rname.c_str(), rt.delay);
+        return false;
+    }
+
+    // Products are now linked in the task input folder
+    for (auto & f: staged) { (void)unlink(f.c_str()); }
+    joins->remove(rname, key);
+    groupRetries.erase(gid);
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: discardGroup
+// Removes a group and the links to its products
+//----------------------------------------------------------------------
+void TaskOrchestrator::discardGroup(string const & rname, string const & key)
+{
+    JoinTable::Group * grp = joins->find(rname, key);
+    if (grp == nullptr) { return; }
+    for (auto & m: grp->prods) {
+        (void)unlink(m["fileinfo"]["full"].get<string>().c_str());
+    }
+    joins->remove(rname, key);
+    groupRetries.erase(JoinTable::groupId(rname, key));
 }
 
 //----------------------------------------------------------------------
@@ -77,7 +291,10 @@ TaskOrchestrator::~TaskOrchestrator()
 bool TaskOrchestrator::checkRules(ProductMeta & prod)
 {
     firedRules.clear();
+    readyGroups.clear();
+    grouped = false;
 
+    bool matched = false;
     string const & pType = prod["type"];
 
     for (auto & kv: rules) {
@@ -87,6 +304,12 @@ bool TaskOrchestrator::checkRules(ProductMeta & prod)
         string inputs = r["inputs"] + ",";
         if (inputs.find(pType) == string::npos) { continue; }
 
+        if (! conditions[rname].eval(prod)) {
+            logger.debug("Condition of rule %s not met by %s product",
+                         rname.c_str(), pType.c_str());
+            continue;
+        }
+
         string procId = r["processing"];
         if (processors.find(procId) == processors.end()) {
             logger.error("Cannot find %s processor config. "
@@ -95,18 +318,35 @@ bool TaskOrchestrator::checkRules(ProductMeta & prod)
             continue;
         }
 
+        if (groupRules.find(rname) != groupRules.end()) {
+            string key;
+            bool ready;
+            if (accumulate(rname, prod, key, ready)) {
+                if (ready) {
+                    readyGroups.push_back(std::make_pair(rname, key));
+                } else {
+                    grouped = true;
+                }
+            }
+            matched = true;
+            continue;
+        }
+
         string processor = processors[procId];
         firedRules.push_back(map<string, string>({{"name", rname},
                         {"processor", processor}}));
         logger.info("Rule %s fired by %s product",
                     rname.c_str(), pType.c_str());
+        matched = true;
     }
 
-    return !firedRules.empty();
+    return matched;
 }
 
 //----------------------------------------------------------------------
 // Method: schedule
+// Launches the tasks of the rules fired by the product.  Returns false
+// only if no task was created and no group holds the product
 //----------------------------------------------------------------------
 bool TaskOrchestrator::schedule(ProductMeta & meta, TaskManager & manager)
 {
@@ -117,8 +357,55 @@ bool TaskOrchestrator::schedule(ProductMeta & meta, TaskManager & manager)
         return false;
     }
 
+    bool kept = grouped;
     for (auto & v: firedRules) {
-        manager.schedule(meta, v["processor"]);
+        if (manager.schedule(meta, v["processor"])) {
+            kept = true;
+        } else {
+            logger.error("Couldn't schedule rule %s for product %s",
+                         v["name"].c_str(),
+                         meta["fileinfo"]["base"].get<std::string>().c_str());
+        }
+    }
+    for (auto & g: readyGroups) {
+        // A failed group may still be kept to be fired again
+        if (fireGroup(g.first, g.second, manager) ||
+            (joins->find(g.first, g.second) != nullptr)) {
+            kept = true;
+        }
+    }
+    return kept;
+}
+
+//----------------------------------------------------------------------
+// Method: checkPendingGroups
+// Fires the group rules whose time window has expired
+//----------------------------------------------------------------------
+void TaskOrchestrator::checkPendingGroups(TaskManager & manager)
+{
+    if (joins->groups().empty()) { return; }
+
+    time_t now = time(nullptr);
+    vector<pair<string, string>> expired;
+    for (auto & kv: joins->groups()) {
+        JoinTable::Group & grp = kv.second;
+        if (groupRules.find(grp.rule) == groupRules.end()) {
+            // Rule no longer in the configuration
+            expired.push_back(std::make_pair(grp.rule, grp.key));
+            continue;
+        }
+        if (isGroupReady(grp.rule, grp, now)) {
+            expired.push_back(std::make_pair(grp.rule, grp.key));
+        }
+    }
+
+    for (auto & g: expired) {
+        if (groupRules.find(g.first) == groupRules.end()) {
+            logger.warn("Discarding group %s of unknown rule %s",
+                        g.second.c_str(), g.first.c_str());
+            discardGroup(g.first, g.second);
+            continue;
+        }
+        fireGroup(g.first, g.second, manager);
     }
-    return true;
 }
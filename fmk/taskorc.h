@@ -60,6 +60,8 @@
 //------------------------------------------------------------
 #include "taskmng.h"
 #include "types.h"
+#include "rulecond.h"
+#include "jointbl.h"
 
 //==========================================================================
 // Class: TaskOrchestrator
@@ -79,9 +81,16 @@ public:
 
     //----------------------------------------------------------------------
     // Method: schedule
+    // Returns false if the product was neither used nor kept by any rule
     //----------------------------------------------------------------------
     bool schedule(ProductMeta & meta, TaskManager & manager);
 
+    //----------------------------------------------------------------------
+    // Method: checkPendingGroups
+    // Fires the group rules whose time window has expired
+    //----------------------------------------------------------------------
+    void checkPendingGroups(TaskManager & manager);
+
 protected:
 
 private:
@@ -90,14 +99,61 @@ private:
     //----------------------------------------------------------------------
     bool checkRules(ProductMeta & prod);
 
+    //----------------------------------------------------------------------
+    // Method: accumulate
+    // Adds the product to the group of a join/count/window rule, and
+    // returns true if the group now holds it
+    //----------------------------------------------------------------------
+    bool accumulate(string const & rname, ProductMeta & prod, string & key,
+                    bool & ready);
+
+    //----------------------------------------------------------------------
+    // Method: isGroupReady
+    //----------------------------------------------------------------------
+    bool isGroupReady(string const & rname, JoinTable::Group & grp, time_t now);
+
+    //----------------------------------------------------------------------
+    // Method: fireGroup
+    // Schedules one task with all the products of the group
+    //----------------------------------------------------------------------
+    bool fireGroup(string const & rname, string const & key,
+                   TaskManager & manager);
+
+    //----------------------------------------------------------------------
+    // Method: discardGroup
+    //----------------------------------------------------------------------
+    void discardGroup(string const & rname, string const & key);
+
+private:
+    struct GroupSpec {
+        string type;
+        string groupBy;
+        vector<string> inputs;
+        int count;
+        int window;
+    };
+
+    struct GroupRetry {
+        time_t next;
+        int delay;
+    };
+
 private:
     Config & cfg;
     string id;
     string workArea;
     map<string, map<string, string>> rules;
+    map<string, RuleCondition> conditions;
+    map<string, GroupSpec> groupRules;
     map<string, string> processors;
 
     vector<map<string, string>> firedRules;
+    vector<pair<string, string>> readyGroups;
+    bool grouped;
+    map<string, GroupRetry> groupRetries;
+
+    string joinArea;
+    JoinTable * joins;
 
     Logger logger;
 };
@@ -0,0 +1,179 @@
+/******************************************************************************
+ * File:    timerwheel.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.TimerWheel
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare TimerWheel class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - vector
+//   - cstddef
+//------------------------------------------------------------
+#include <vector>
+#include <cstddef>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+
+//==========================================================================
+// Class: TimerWheel
+// Hierarchical timer wheel with two levels: the inner one has one slot
+// per tick, and the outer one a slot per inner wheel revolution.
+// Timers beyond the outer wheel are kept in an overflow list, checked
+// once per inner revolution.  Scheduling is O(1), and advancing is O(1)
+// amortized per tick and per timer.  Times are given in ms, in any
+// monotonic time base.  Not thread safe.
+//==========================================================================
+template<typename T>
+class TimerWheel {
+
+    static const long long InnerSlots = 256;
+    static const long long OuterSlots = 64;
+
+    struct Entry {
+        long long due;
+        T         item;
+    };
+
+    typedef std::vector<Entry> Slot;
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    TimerWheel(int _tickMs, long long nowMs)
+        : tickMs(_tickMs), tick(nowMs / _tickMs), count(0),
+          inner(InnerSlots), outer(OuterSlots) {}
+
+    //----------------------------------------------------------------------
+    // Method: schedule
+    // Adds the item, to expire at the given time (at the next tick at
+    // the earliest)
+    //----------------------------------------------------------------------
+    void schedule(T item, long long dueMs) {
+        long long due = dueMs / tickMs;
+        if (due <= tick) { due = tick + 1; }
+        place(Entry {due, std::move(item)});
+        ++count;
+    }
+
+    //----------------------------------------------------------------------
+    // Method: advance
+    // Moves the wheel up to the given time, appending the expired items
+    //----------------------------------------------------------------------
+    void advance(long long nowMs, std::vector<T> & expired) {
+        long long target = nowMs / tickMs;
+        while ((tick < target) && (count > 0)) {
+            ++tick;
+            if ((tick % InnerSlots) == 0) { cascade(); }
+            Slot & slot = inner[tick % InnerSlots];
+            for (auto & e: slot) {
+                expired.push_back(std::move(e.item));
+                --count;
+            }
+            slot.clear();
+        }
+        // The wheel is empty, so it can jump to the target
+        if (tick < target) { tick = target; }
+    }
+
+    //----------------------------------------------------------------------
+    // Method: size
+    //----------------------------------------------------------------------
+    size_t size() const { return count; }
+
+    //----------------------------------------------------------------------
+    // Method: empty
+    //----------------------------------------------------------------------
+    bool empty() const { return count == 0; }
+
+private:
+    //----------------------------------------------------------------------
+    // Method: place
+    // Puts the entry in the slot of the inner or outer wheel, or in the
+    // overflow list
+    //----------------------------------------------------------------------
+    void place(Entry && e) {
+        if (e.due / InnerSlots == tick / InnerSlots) {
+            inner[e.due % InnerSlots].push_back(std::move(e));
+        } else if (e.due / InnerSlots - tick / InnerSlots < OuterSlots) {
+            outer[(e.due / InnerSlots) % OuterSlots].push_back(std::move(e));
+        } else {
+            overflow.push_back(std::move(e));
+        }
+    }
+
+    //----------------------------------------------------------------------
+    // Method: cascade
+    // At the start of an inner revolution, distributes the timers of the
+    // corresponding outer slot, and those of the overflow list that now
+    // fit in the wheels
+    //----------------------------------------------------------------------
+    void cascade() {
+        Slot slot;
+        slot.swap(outer[(tick / InnerSlots) % OuterSlots]);
+        for (auto & e: slot) { place(std::move(e)); }
+
+        Slot over;
+        over.swap(overflow);
+        for (auto & e: over) { place(std::move(e)); }
+    }
+
+private:
+    int tickMs;
+    long long tick;
+    size_t count;
+
+    std::vector<Slot> inner;
+    std::vector<Slot> outer;
+    Slot overflow;
+};
+
+#endif // TIMERWHEEL_H
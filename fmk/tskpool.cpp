@@ -0,0 +1,291 @@
+/******************************************************************************
+ * File:    tskpool.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.TaskFolderPool
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement TaskFolderPool class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#include "tskpool.h"
+
+#include "types.h"
+#include "str.h"
+
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+static const char * SkeletonSubFolders[] = { "in", "out", "log" };
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+TaskFolderPool::TaskFolderPool(std::string _tasksDir, int _size)
+    : tasksDir(_tasksDir), poolDir(_tasksDir + "/.pool"),
+      size(_size), available(0), counter(0), quit(false),
+      logger(Log::getLogger("tskpool"))
+{
+    if (size > (int)(ready.capacity())) { size = (int)(ready.capacity()); }
+    for (auto & p: {poolDir, poolDir + "/cfg"}) {
+        if ((mkdir(p.c_str(), PathMode) < 0) && (errno != EEXIST)) {
+            logger.error("Couldn't create folder %s: %s",
+                         p.c_str(), strerror(errno));
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------
+TaskFolderPool::~TaskFolderPool()
+{
+    stop();
+}
+
+//----------------------------------------------------------------------
+// Method: start
+// Launches the thread that keeps the pool filled
+//----------------------------------------------------------------------
+void TaskFolderPool::start()
+{
+    if (filler.joinable()) { return; }
+    quit = false;
+    filler = std::thread(&TaskFolderPool::run, this);
+}
+
+//----------------------------------------------------------------------
+// Method: stop
+// Stops the filler thread, and removes the unused skeletons
+//----------------------------------------------------------------------
+void TaskFolderPool::stop()
+{
+    if (! filler.joinable()) { return; }
+    {
+        std::lock_guard<std::mutex> lock(fillMtx);
+        quit = true;
+    }
+    fillCv.notify_all();
+    filler.join();
+
+    std::string dir;
+    while (ready.tryPop(dir)) { removeSkeleton(dir); }
+    available = 0;
+}
+
+//----------------------------------------------------------------------
+// Method: acquire
+// Places a task folder skeleton at the given path, renaming one from
+// the pool if available, or creating it otherwise
+//----------------------------------------------------------------------
+bool TaskFolderPool::acquire(std::string & taskFld)
+{
+    std::string dir;
+    if (ready.tryPop(dir)) {
+        available--;
+        fillCv.notify_one();
+        if (rename(dir.c_str(), taskFld.c_str()) == 0) { return true; }
+        logger.warn("Couldn't rename %s to %s: %s", dir.c_str(),
+                    taskFld.c_str(), strerror(errno));
+        removeSkeleton(dir);
+    } else {
+        logger.debug("Task folder pool is empty");
+    }
+    return createSkeleton(taskFld);
+}
+
+//----------------------------------------------------------------------
+// Method: release
+// Only the files of the skeleton are expected, so that no recursion
+// is needed
+//----------------------------------------------------------------------
+void TaskFolderPool::release(std::string & taskFld)
+{
+    std::vector<std::string> dirs {taskFld};
+    for (auto & sub: SkeletonSubFolders) { dirs.push_back(taskFld + "/" + sub); }
+    for (auto & d: dirs) {
+        DIR * dir = opendir(d.c_str());
+        if (dir == nullptr) { continue; }
+        struct dirent * ent;
+        while ((ent = readdir(dir)) != nullptr) {
+            std::string f = d + "/" + ent->d_name;
+            struct stat st;
+            if ((lstat(f.c_str(), &st) == 0) && (! S_ISDIR(st.st_mode))) {
+                (void)unlink(f.c_str());
+            }
+        }
+        closedir(dir);
+    }
+    removeSkeleton(taskFld);
+}
+
+//----------------------------------------------------------------------
+// Method: placeConfig
+// Places the processor configuration file at the given path.  The
+// content of the source file is cached (and reloaded when it changes),
+// and a master copy is kept in the pool, so that it is hard linked
+// into the task folder, or written at once if linking is not possible
+//----------------------------------------------------------------------
+bool TaskFolderPool::placeConfig(std::string & srcCfg, std::string & tgtCfg)
+{
+    struct stat st;
+    if (stat(srcCfg.c_str(), &st) < 0) {
+        logger.error("Cannot access processor config. file %s: %s",
+                     srcCfg.c_str(), strerror(errno));
+        return false;
+    }
+
+    auto it = cfgTemplates.find(srcCfg);
+    if ((it == cfgTemplates.end()) ||
+        (it->second.mtime != st.st_mtime) || (it->second.size != st.st_size)) {
+        CfgTemplate tpl;
+        tpl.mtime = st.st_mtime;
+        tpl.size = st.st_size;
+        tpl.content.resize(st.st_size);
+        int fd = open(srcCfg.c_str(), O_RDONLY | O_CLOEXEC);
+        ssize_t n = (fd < 0) ? -1 : pread(fd, &tpl.content[0], st.st_size, 0);
+        if (fd >= 0) { close(fd); }
+        if (n != st.st_size) {
+            logger.error("Cannot read processor config. file %s",
+                         srcCfg.c_str());
+            return false;
+        }
+
+        // New master copy, with a new name so that already linked
+        // copies are not modified
+        tpl.master = (poolDir + "/cfg/" + str::getBaseName(tgtCfg) + "." +
+                      std::to_string(counter++));
+        if (! writeFile(tpl.master, tpl.content)) { tpl.master.clear(); }
+        if (it != cfgTemplates.end()) {
+            if (! it->second.master.empty()) {
+                unlink(it->second.master.c_str());
+            }
+            it->second = std::move(tpl);
+        } else {
+            it = cfgTemplates.emplace(srcCfg, std::move(tpl)).first;
+        }
+    }
+
+    CfgTemplate & tpl = it->second;
+    if ((! tpl.master.empty()) &&
+        (link(tpl.master.c_str(), tgtCfg.c_str()) == 0)) {
+        return true;
+    }
+    return writeFile(tgtCfg, tpl.content);
+}
+
+//----------------------------------------------------------------------
+// Method: run
+// Keeps the pool filled
+//----------------------------------------------------------------------
+void TaskFolderPool::run()
+{
+    std::unique_lock<std::mutex> lock(fillMtx);
+    while (! quit) {
+        lock.unlock();
+        while ((! quit) && (available < size)) {
+            std::string dir = (poolDir + "/skel-" + std::to_string(getpid()) +
+                               "-" + std::to_string(counter++));
+            if (! createSkeleton(dir)) { break; }
+            ready.push(std::move(dir));
+            available++;
+        }
+        lock.lock();
+        if (quit) { break; }
+        fillCv.wait_for(lock, std::chrono::seconds(1));
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: createSkeleton
+// Creates the folder and its subfolders
+//----------------------------------------------------------------------
+bool TaskFolderPool::createSkeleton(std::string & dir)
+{
+    if (mkdir(dir.c_str(), PathMode) < 0) {
+        logger.error("Couldn't create folder %s: %s",
+                     dir.c_str(), strerror(errno));
+        return false;
+    }
+    int dfd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    bool ok = (dfd >= 0);
+    for (auto & sub: SkeletonSubFolders) {
+        if ((dfd < 0) || (mkdirat(dfd, sub, PathMode) < 0)) {
+            logger.error("Couldn't create folder %s/%s: %s",
+                         dir.c_str(), sub, strerror(errno));
+            ok = false;
+        }
+    }
+    if (dfd >= 0) { close(dfd); }
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// Method: removeSkeleton
+// Removes an unused (empty) skeleton
+//----------------------------------------------------------------------
+void TaskFolderPool::removeSkeleton(std::string & dir)
+{
+    for (auto & sub: SkeletonSubFolders) {
+        rmdir((dir + "/" + sub).c_str());
+    }
+    rmdir(dir.c_str());
+}
+
+//----------------------------------------------------------------------
+// Method: writeFile
+// Creates a file with the given content, in a single write
+//----------------------------------------------------------------------
+bool TaskFolderPool::writeFile(std::string & fileName, std::string & content)
+{
+    int fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  0644);
+    if (fd < 0) {
+        logger.error("Cannot create file %s: %s",
+                     fileName.c_str(), strerror(errno));
+        return false;
+    }
+    ssize_t n = write(fd, content.data(), content.size());
+    close(fd);
+    if (n != (ssize_t)(content.size())) {
+        logger.error("Cannot write file %s", fileName.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,171 @@
+/******************************************************************************
+ * File:    tskpool.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.TaskFolderPool
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare TaskFolderPool class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#ifndef TASKFOLDERPOOL_H
+#define TASKFOLDERPOOL_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//   - map
+//   - thread
+//------------------------------------------------------------
+#include <string>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#include <sys/types.h>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+#include "log.h"
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+#include "spscring.h"
+
+//==========================================================================
+// Class: TaskFolderPool
+// Keeps a number of task folder skeletons (with their in, out and log
+// subfolders) ready under the tasks folder, created by a background
+// thread.  A new task takes one of them and renames it atomically to
+// its final name.  It also caches the processor configuration
+// templates, so that they are placed in the task folders with a hard
+// link (or a single write) instead of a copy.
+//==========================================================================
+class TaskFolderPool {
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    TaskFolderPool(std::string _tasksDir, int _size = 8);
+
+    //----------------------------------------------------------------------
+    // Destructor
+    //----------------------------------------------------------------------
+    virtual ~TaskFolderPool();
+
+    //----------------------------------------------------------------------
+    // Method: start
+    //----------------------------------------------------------------------
+    void start();
+
+    //----------------------------------------------------------------------
+    // Method: stop
+    //----------------------------------------------------------------------
+    void stop();
+
+    //----------------------------------------------------------------------
+    // Method: acquire
+    // Places a task folder skeleton at the given path
+    //----------------------------------------------------------------------
+    bool acquire(std::string & taskFld);
+
+    //----------------------------------------------------------------------
+    // Method: release
+    // Removes a task folder that could not be completed, and the files
+    // already placed in it
+    //----------------------------------------------------------------------
+    void release(std::string & taskFld);
+
+    //----------------------------------------------------------------------
+    // Method: placeConfig
+    // Places the processor configuration file at the given path
+    //----------------------------------------------------------------------
+    bool placeConfig(std::string & srcCfg, std::string & tgtCfg);
+
+private:
+    //----------------------------------------------------------------------
+    // Method: run
+    //----------------------------------------------------------------------
+    void run();
+
+    //----------------------------------------------------------------------
+    // Method: createSkeleton
+    //----------------------------------------------------------------------
+    bool createSkeleton(std::string & dir);
+
+    //----------------------------------------------------------------------
+    // Method: removeSkeleton
+    //----------------------------------------------------------------------
+    void removeSkeleton(std::string & dir);
+
+    //----------------------------------------------------------------------
+    // Method: writeFile
+    //----------------------------------------------------------------------
+    bool writeFile(std::string & fileName, std::string & content);
+
+private:
+    struct CfgTemplate {
+        time_t      mtime;
+        off_t       size;
+        std::string content;
+        std::string master;
+    };
+
+    std::string tasksDir;
+    std::string poolDir;
+    int size;
+
+    SpscRing<std::string, 64> ready;
+    std::atomic<int> available;
+    std::atomic<unsigned long> counter;
+
+    std::map<std::string, CfgTemplate> cfgTemplates;
+
+    std::atomic<bool> quit;
+    std::mutex fillMtx;
+    std::condition_variable fillCv;
+    std::thread filler;
+
+    Logger logger;
+};
+
+#endif // TASKFOLDERPOOL_H
@@ -244,17 +244,62 @@ int indexOf(const std::vector<T>& v, const T& elem)
 
 typedef map<string, int> AgentSpectrum;
 
+// Number of containers an agent may run at the same time, in total and
+// for each processor class
+struct AgentSlots {
+    int                 total;
+    map<string, string> procClass;
+    map<string, int>    classLimit;
+};
+
+// Set of CPUs (and their NUMA nodes) reserved for a container slot.
+// nodeCpus are all the CPUs of those NUMA nodes
+struct CpuSlot {
+    string cpus;
+    string mems;
+    string nodeCpus;
+};
+
+// Watchdog limits of the tasks of a processor, in seconds (0 for none):
+// maximum wall-clock time, and maximum time without log growth
+struct TaskLimits {
+    int timeLimit;
+    int stallTime;
+};
+
+// Settings of the agents of a node.  The CPU slots are specific to
+// each agent, the rest are common to all of them
+struct AgentSettings {
+    int                 heartBeat;
+    AgentSlots          slots;
+    string              containerBackend;
+    string              dockerSocket;
+    bool                containerEvents;
+    map<string, int>    warmPool;
+    map<string, string> nativeCgroup;
+    bool                autoRemove;
+    vector<CpuSlot>     cpuSlots;
+    string              defaultPinning;
+    map<string, string> procPinning;
+    vector<string>      streamOutputs;
+    TaskLimits          defaultLimits;
+    map<string, TaskLimits> procLimits;
+    vector<string>      speculative;
+};
+
 string agentSpectrumToStr(AgentSpectrum & sp);
 
 struct AgentData {
     int num_tasks;
+    int pending;
     string task_id;
     string cont_id;
     TaskStatus cont_status;
     AgentSpectrum spectrum;
 
     string str() {
-        return ("\"num_tasks\": " + std::to_string(num_tasks) + ", " +
+        return ("{\"num_tasks\": " + std::to_string(num_tasks) + ", " +
+                "\"pending\": " + std::to_string(pending) + ", " +
                 "\"task_id\": \"" + task_id + "\", " +
                 "\"cont_id\": \"" + cont_id + "\", " +
                 "\"cont_status\": \"" + TaskStatusStr[cont_status] + "\", " +
@@ -0,0 +1,436 @@
+/******************************************************************************
+ * File:    uxhttpcli.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.UnixHttpClient
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement UnixHttpClient class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#include "uxhttpcli.h"
+
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <poll.h>
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+UnixHttpClient::UnixHttpClient(std::string _sockPath, int _timeOutSec)
+    : sockPath(_sockPath), timeOutSec(_timeOutSec), fd(-1), rpos(0),
+      responseStarted(false), onIdle(nullptr), idleMs(0)
+{
+}
+
+//----------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------
+UnixHttpClient::~UnixHttpClient()
+{
+    disconnect();
+}
+
+//----------------------------------------------------------------------
+// Method: request
+// Sends the request and waits for the response.  A reused connection
+// found closed by the server is replaced before sending.  The request
+// is retried on a new connection only if it could not be sent on a
+// reused one, or (if idempotent) when the connection was closed before
+// any byte of the response arrived.  A POST is never sent twice, since
+// it may create or start a container or exec
+//----------------------------------------------------------------------
+int UnixHttpClient::request(const std::string & method, const std::string & path,
+                            const std::string & body, std::string & respBody)
+{
+    std::string req = (method + " " + path + " HTTP/1.1\r\n" +
+                       "Host: docker\r\n");
+    if ((! body.empty()) || (method == "POST") || (method == "PUT")) {
+        req += ("Content-Type: application/json\r\n"
+                "Content-Length: " + std::to_string(body.size()) + "\r\n");
+    }
+    req += "\r\n" + body;
+
+    bool idempotent = (method != "POST");
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if ((fd >= 0) && (! connectionAlive())) { disconnect(); }
+        bool reused = (fd >= 0);
+        if ((! reused) && (! connectSocket())) { return -1; }
+
+        if (! sendAll(req)) {
+            disconnect();
+            if (reused) { continue; }
+            break;
+        }
+
+        int status;
+        bool keepAlive;
+        responseStarted = false;
+        if (readResponse(method, status, respBody, keepAlive)) {
+            if (! keepAlive) { disconnect(); }
+            return status;
+        }
+
+        disconnect();
+        if ((! reused) || (! idempotent) || responseStarted) { break; }
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// Method: stream
+// Sends the request on a new connection, and passes the body pieces
+// (the chunks, if chunked encoding is used) to the handler
+//----------------------------------------------------------------------
+int UnixHttpClient::stream(const std::string & method, const std::string & path,
+                           StreamHandler onData, int _idleMs)
+{
+    disconnect();
+    if (! connectSocket()) { return -1; }
+
+    std::string req = (method + " " + path + " HTTP/1.1\r\n" +
+                       "Host: docker\r\n\r\n");
+
+    int status;
+    long contentLength;
+    bool chunked, keepAlive;
+    if ((! sendAll(req)) ||
+        (! readHead(status, contentLength, chunked, keepAlive))) {
+        disconnect();
+        return -1;
+    }
+
+    if (status != 200) {
+        // Keep the error message sent by the server
+        std::string body;
+        if (readBody(contentLength, chunked, keepAlive, body)) {
+            errMsg = body;
+        }
+        disconnect();
+        return status;
+    }
+
+    onIdle = &onData;
+    idleMs = _idleMs;
+
+    std::string line, data;
+    if (chunked) {
+        while (readLine(line)) {
+            size_t sz = std::strtoul(line.c_str(), nullptr, 16);
+            if (sz == 0) { break; }
+            data.clear();
+            if ((! readBytes(sz, data)) || (! readLine(line))) { break; }
+            if (! onData(data)) { break; }
+        }
+    } else {
+        // The body is whatever arrives until the connection is closed
+        do {
+            if (rpos < rbuf.size()) {
+                data = rbuf.substr(rpos);
+                rbuf.clear();
+                rpos = 0;
+                if (! onData(data)) { break; }
+            }
+        } while (fillBuffer());
+    }
+
+    onIdle = nullptr;
+    disconnect();
+    return status;
+}
+
+//----------------------------------------------------------------------
+// Method: connectSocket
+// Opens the connection to the server socket
+//----------------------------------------------------------------------
+bool UnixHttpClient::connectSocket()
+{
+    struct sockaddr_un addr;
+    if (sockPath.size() >= sizeof(addr.sun_path)) {
+        return fail("Socket path too long: " + sockPath);
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) { return fail(std::string("socket: ") + strerror(errno)); }
+
+    struct timeval tv;
+    tv.tv_sec = timeOutSec;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, sockPath.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *)(&addr), sizeof(addr)) < 0) {
+        std::string msg("connect " + sockPath + ": " + strerror(errno));
+        disconnect();
+        return fail(msg);
+    }
+
+    rbuf.clear();
+    rpos = 0;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: connectionAlive
+// Tells whether the kept-alive connection can still be used: nothing
+// (not even the end of file) must be pending to be read on it
+//----------------------------------------------------------------------
+bool UnixHttpClient::connectionAlive()
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int r;
+    do {
+        r = poll(&pfd, 1, 0);
+    } while ((r < 0) && (errno == EINTR));
+    return (r == 0);
+}
+
+//----------------------------------------------------------------------
+// Method: disconnect
+// Closes the connection, if open
+//----------------------------------------------------------------------
+void UnixHttpClient::disconnect()
+{
+    if (fd >= 0) { close(fd); }
+    fd = -1;
+    rbuf.clear();
+    rpos = 0;
+}
+
+//----------------------------------------------------------------------
+// Method: sendAll
+//----------------------------------------------------------------------
+bool UnixHttpClient::sendAll(const std::string & data)
+{
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent,
+                         MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            return fail(std::string("send: ") + strerror(errno));
+        }
+        sent += n;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: fillBuffer
+// Reads more data from the socket into the buffer
+//----------------------------------------------------------------------
+bool UnixHttpClient::fillBuffer()
+{
+    if (rpos > 0) {
+        rbuf.erase(0, rpos);
+        rpos = 0;
+    }
+    // While streaming, wait for data in idle periods, so that the
+    // stream handler can decide to stop
+    while (onIdle != nullptr) {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int r = poll(&pfd, 1, idleMs);
+        if (r > 0) { break; }
+        if (r < 0) {
+            if (errno == EINTR) { continue; }
+            return fail(std::string("poll: ") + strerror(errno));
+        }
+        if (! (*onIdle)(std::string())) { return fail("Stream stopped"); }
+    }
+
+    char buf[16384];
+    ssize_t n;
+    do {
+        n = recv(fd, buf, sizeof(buf), 0);
+    } while ((n < 0) && (errno == EINTR));
+    if (n < 0) { return fail(std::string("recv: ") + strerror(errno)); }
+    if (n == 0) { return fail("Connection closed by server"); }
+    rbuf.append(buf, n);
+    responseStarted = true;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: readLine
+// Reads a CRLF terminated line (without the terminator)
+//----------------------------------------------------------------------
+bool UnixHttpClient::readLine(std::string & line)
+{
+    size_t eol;
+    while ((eol = rbuf.find("\r\n", rpos)) == std::string::npos) {
+        if (! fillBuffer()) { return false; }
+    }
+    line = rbuf.substr(rpos, eol - rpos);
+    rpos = eol + 2;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: readBytes
+// Reads exactly n bytes, appending them to out
+//----------------------------------------------------------------------
+bool UnixHttpClient::readBytes(size_t n, std::string & out)
+{
+    while (rbuf.size() - rpos < n) {
+        if (! fillBuffer()) { return false; }
+    }
+    out.append(rbuf, rpos, n);
+    rpos += n;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: readResponse
+// Reads status line, headers and body of the response
+//----------------------------------------------------------------------
+bool UnixHttpClient::readResponse(const std::string & method, int & status,
+                                  std::string & body, bool & keepAlive)
+{
+    long contentLength;
+    bool chunked;
+    if (! readHead(status, contentLength, chunked, keepAlive)) { return false; }
+
+    body.clear();
+    if ((method == "HEAD") || (status == 204) || (status == 304) ||
+        ((status >= 100) && (status < 200))) {
+        return true;
+    }
+
+    return readBody(contentLength, chunked, keepAlive, body);
+}
+
+//----------------------------------------------------------------------
+// Method: readHead
+// Reads status line and headers of the response
+//----------------------------------------------------------------------
+bool UnixHttpClient::readHead(int & status, long & contentLength,
+                              bool & chunked, bool & keepAlive)
+{
+    std::string line;
+    if (! readLine(line)) { return false; }
+    // HTTP/1.1 200 OK
+    size_t sp = line.find(' ');
+    if ((line.compare(0, 5, "HTTP/") != 0) || (sp == std::string::npos)) {
+        return fail("Malformed status line: " + line);
+    }
+    status = std::atoi(line.c_str() + sp + 1);
+    keepAlive = (line.compare(0, 8, "HTTP/1.0") != 0);
+
+    contentLength = -1;
+    chunked = false;
+    while (readLine(line)) {
+        if (line.empty()) { break; }
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) { continue; }
+        std::string key = line.substr(0, colon);
+        std::string value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+        std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+        if (key == "content-length") {
+            contentLength = std::atol(value.c_str());
+        } else if (key == "transfer-encoding") {
+            chunked = (value.find("chunked") != std::string::npos);
+        } else if (key == "connection") {
+            keepAlive = (value.find("close") == std::string::npos);
+        }
+    }
+    return line.empty();
+}
+
+//----------------------------------------------------------------------
+// Method: readBody
+// Reads the complete body of the response
+//----------------------------------------------------------------------
+bool UnixHttpClient::readBody(long contentLength, bool chunked,
+                              bool & keepAlive, std::string & body)
+{
+    std::string line;
+    body.clear();
+    if (chunked) {
+        while (readLine(line)) {
+            size_t sz = std::strtoul(line.c_str(), nullptr, 16);
+            if (sz == 0) {
+                // Trailers, up to the empty line
+                while (readLine(line) && (! line.empty())) {}
+                return true;
+            }
+            if ((! readBytes(sz, body)) || (! readLine(line))) { return false; }
+        }
+        return false;
+    }
+
+    if (contentLength >= 0) {
+        return readBytes(contentLength, body);
+    }
+
+    // No length: body ends when the connection is closed
+    keepAlive = false;
+    while (true) {
+        body.append(rbuf, rpos, std::string::npos);
+        rbuf.clear();
+        rpos = 0;
+        char buf[16384];
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) { break; }
+        rbuf.append(buf, n);
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: fail
+// Stores the error message, and returns false
+//----------------------------------------------------------------------
+bool UnixHttpClient::fail(const std::string & msg)
+{
+    errMsg = msg;
+    return false;
+}
@@ -0,0 +1,190 @@
+/******************************************************************************
+ * File:    uxhttpcli.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.UnixHttpClient
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare UnixHttpClient class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+#ifndef UNIXHTTPCLIENT_H
+#define UNIXHTTPCLIENT_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//   - functional
+//------------------------------------------------------------
+#include <string>
+#include <functional>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+
+//==========================================================================
+// Class: UnixHttpClient
+// Minimal HTTP/1.1 client over a Unix domain socket (i.e. the Docker
+// Engine socket).  The connection is kept alive between requests, and
+// re-opened when the server closed it.  Only requests that were not
+// sent, or idempotent ones without any response, are retried.
+// Responses with Content-Length or chunked encoding are supported, as
+// well as endless streamed responses (i.e. /events).
+// An instance must not be shared between threads.
+//==========================================================================
+class UnixHttpClient {
+
+public:
+    // Receives each piece of a streamed response body.  It is called
+    // with an empty string when no data arrived in the idle period.
+    // Returning false stops the streaming
+    typedef std::function<bool(const std::string & data)> StreamHandler;
+
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    UnixHttpClient(std::string _sockPath = std::string("/var/run/docker.sock"),
+                   int _timeOutSec = 60);
+
+    //----------------------------------------------------------------------
+    // Destructor
+    //----------------------------------------------------------------------
+    virtual ~UnixHttpClient();
+
+    //----------------------------------------------------------------------
+    // Method: request
+    // Sends the request and waits for the response.  Returns the HTTP
+    // status code, or -1 on communication error
+    //----------------------------------------------------------------------
+    int request(const std::string & method, const std::string & path,
+                const std::string & body, std::string & respBody);
+
+    //----------------------------------------------------------------------
+    // Method: stream
+    // Sends the request on a new connection and passes the response
+    // body to the handler as it arrives, until the server closes the
+    // connection or the handler returns false.  Returns the HTTP status
+    // code, or -1 on communication error
+    //----------------------------------------------------------------------
+    int stream(const std::string & method, const std::string & path,
+               StreamHandler onData, int idleMs = 500);
+
+    //----------------------------------------------------------------------
+    // Method: lastError
+    //----------------------------------------------------------------------
+    const std::string & lastError() const { return errMsg; }
+
+    //----------------------------------------------------------------------
+    // Method: disconnect
+    //----------------------------------------------------------------------
+    void disconnect();
+
+private:
+    //----------------------------------------------------------------------
+    // Method: connectSocket
+    //----------------------------------------------------------------------
+    bool connectSocket();
+
+    //----------------------------------------------------------------------
+    // Method: connectionAlive
+    //----------------------------------------------------------------------
+    bool connectionAlive();
+
+    //----------------------------------------------------------------------
+    // Method: sendAll
+    //----------------------------------------------------------------------
+    bool sendAll(const std::string & data);
+
+    //----------------------------------------------------------------------
+    // Method: readResponse
+    //----------------------------------------------------------------------
+    bool readResponse(const std::string & method, int & status,
+                      std::string & body, bool & keepAlive);
+
+    //----------------------------------------------------------------------
+    // Method: readHead
+    //----------------------------------------------------------------------
+    bool readHead(int & status, long & contentLength, bool & chunked,
+                  bool & keepAlive);
+
+    //----------------------------------------------------------------------
+    // Method: readBody
+    //----------------------------------------------------------------------
+    bool readBody(long contentLength, bool chunked, bool & keepAlive,
+                  std::string & body);
+
+    //----------------------------------------------------------------------
+    // Method: fillBuffer
+    //----------------------------------------------------------------------
+    bool fillBuffer();
+
+    //----------------------------------------------------------------------
+    // Method: readLine
+    //----------------------------------------------------------------------
+    bool readLine(std::string & line);
+
+    //----------------------------------------------------------------------
+    // Method: readBytes
+    //----------------------------------------------------------------------
+    bool readBytes(size_t n, std::string & out);
+
+    //----------------------------------------------------------------------
+    // Method: fail
+    //----------------------------------------------------------------------
+    bool fail(const std::string & msg);
+
+private:
+    std::string sockPath;
+    int timeOutSec;
+    int fd;
+
+    std::string rbuf;
+    size_t rpos;
+    bool responseStarted;
+
+    StreamHandler * onIdle;
+    int idleMs;
+
+    std::string errMsg;
+};
+
+#endif // UNIXHTTPCLIENT_H
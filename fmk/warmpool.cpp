@@ -0,0 +1,188 @@
+/******************************************************************************
+ * File:    warmpool.cpp
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.WarmContainerPool
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Implement WarmContainerPool class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#include "warmpool.h"
+
+#include <chrono>
+
+//----------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------
+WarmContainerPool::WarmContainerPool(std::shared_ptr<DockerMng> _dckMng,
+                                     std::vector<std::string> _labels,
+                                     std::map<std::string, std::string> _mounts,
+                                     std::map<std::string, int> _sizes)
+    : dckMng(_dckMng), labels(_labels), mounts(_mounts), sizes(_sizes),
+      quit(false),
+      logger(Log::getLogger("warmpool"))
+{
+}
+
+//----------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------
+WarmContainerPool::~WarmContainerPool()
+{
+    stop();
+}
+
+//----------------------------------------------------------------------
+// Method: start
+// Launches the filler thread
+//----------------------------------------------------------------------
+void WarmContainerPool::start()
+{
+    if (filler.joinable()) { return; }
+    quit = false;
+    filler = std::thread(&WarmContainerPool::run, this);
+}
+
+//----------------------------------------------------------------------
+// Method: stop
+// Stops the filler thread, and removes the idle containers
+//----------------------------------------------------------------------
+void WarmContainerPool::stop()
+{
+    if (! filler.joinable()) { return; }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        quit = true;
+    }
+    fillCv.notify_all();
+    filler.join();
+
+    for (auto & kv: idle) {
+        for (auto & contId: kv.second) {
+            dckMng->kill(contId);
+            dckMng->remove(contId);
+        }
+        kv.second.clear();
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: acquire
+// Takes an idle container for the image, if there is one, and wakes
+// up the filler to replace it
+//----------------------------------------------------------------------
+bool WarmContainerPool::acquire(const std::string & image, std::string & contId)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = idle.find(image);
+        if ((it == idle.end()) || it->second.empty()) { return false; }
+        contId = it->second.front();
+        it->second.pop_front();
+    }
+    fillCv.notify_one();
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Method: bindCommand
+// Wraps the task command so that its exit code is written to the FIFO
+// the main process of the warm container is waiting on
+//----------------------------------------------------------------------
+void WarmContainerPool::bindCommand(std::string & exe,
+                                    std::vector<std::string> & args)
+{
+    std::vector<std::string> wrapped {"-c", BindScript, "qpf", exe};
+    wrapped.insert(wrapped.end(), args.begin(), args.end());
+    exe = "sh";
+    args.swap(wrapped);
+}
+
+//----------------------------------------------------------------------
+// Method: run
+// Keeps the number of idle containers of each image at the requested
+// level.  Creation is done out of the lock, so that acquire never waits
+//----------------------------------------------------------------------
+void WarmContainerPool::run()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (! quit) {
+        bool failed = false;
+        for (auto & kv: sizes) {
+            const std::string & image = kv.first;
+            while ((! quit) && (! failed) &&
+                   ((int)(idle[image].size()) < kv.second)) {
+                lock.unlock();
+                std::string contId;
+                failed = (! createWarm(image, contId));
+                lock.lock();
+                if (! failed) { idle[image].push_back(contId); }
+            }
+        }
+        // On failure, retry only after the refill period
+        fillCv.wait_for(lock, std::chrono::milliseconds(RefillPeriod));
+    }
+}
+
+//----------------------------------------------------------------------
+// Method: createWarm
+// Creates a new idle container for the image
+//----------------------------------------------------------------------
+bool WarmContainerPool::createWarm(const std::string & image,
+                                   std::string & contId)
+{
+    std::vector<std::string> opts {"--label", "qpf.warm=" + image};
+    for (auto & l: labels) {
+        opts.push_back("--label");
+        opts.push_back(l);
+    }
+
+    std::string cmd_line;
+    if (! dckMng->createContainer(image, opts, mounts, "sh",
+                                  {"-c", WarmEntryScript},
+                                  contId, cmd_line)) {
+        logger.warn("Cannot create warm container: " + cmd_line);
+        return false;
+    }
+    logger.debug("Warm container %s ready for image %s",
+                 contId.c_str(), image.c_str());
+    return true;
+}
+
+const std::string WarmContainerPool::WarmEntryScript("mkfifo /tmp/qpf.rc && "
+                                                     "exit $(cat /tmp/qpf.rc)");
+const std::string WarmContainerPool::BindScript("\"$@\"; echo $? > /tmp/qpf.rc");
+
+const int WarmContainerPool::RefillPeriod = 5000;
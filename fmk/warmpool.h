@@ -0,0 +1,159 @@
+/******************************************************************************
+ * File:    warmpool.h
+ *          This file is part of QPF
+ *
+ * Domain:  qpf.fmk.WarmContainerPool
+ *
+ * Last update:  1.0
+ *
+ * Date:    20190614
+ *
+ * Author:  J C Gonzalez
+ *
+ * Copyright (C) 2019 Euclid SOC Team / J C Gonzalez
+ *_____________________________________________________________________________
+ *
+ * Topic: General Information
+ *
+ * Purpose:
+ *   Declare WarmContainerPool class
+ *
+ * Created by:
+ *   J C Gonzalez
+ *
+ * Status:
+ *   Prototype
+ *
+ * Dependencies:
+ *   TBD
+ *
+ * Files read / modified:
+ *   none
+ *
+ * History:
+ *   See <Changelog> file
+ *
+ * About: License Conditions
+ *   See <License> file
+ *
+ ******************************************************************************/
+
+
+#ifndef WARMCONTAINERPOOL_H
+#define WARMCONTAINERPOOL_H
+
+//============================================================
+// Group: External Dependencies
+//============================================================
+
+//------------------------------------------------------------
+// Topic: System headers
+//   - string
+//   - map
+//   - deque
+//   - memory
+//   - thread
+//   - atomic
+//   - mutex
+//   - condition_variable
+//------------------------------------------------------------
+#include <string>
+#include <map>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+//------------------------------------------------------------
+// Topic: External packages
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Topic: Project headers
+//------------------------------------------------------------
+#include "dckmng.h"
+#include "log.h"
+
+//==========================================================================
+// Class: WarmContainerPool
+// Keeps a number of idle containers ready for each processor image,
+// with the tasks and processors areas already mounted.  Each of them
+// just waits (blocked on a FIFO) for the exit code of the task that
+// will be bound to it with docker exec, and then exits with it, so
+// that a warm container has the same life-cycle as a cold one.  The
+// pool is refilled in its own thread, with its own container manager
+//==========================================================================
+class WarmContainerPool {
+
+public:
+    //----------------------------------------------------------------------
+    // Constructor
+    //----------------------------------------------------------------------
+    WarmContainerPool(std::shared_ptr<DockerMng> _dckMng,
+                      std::vector<std::string> _labels,
+                      std::map<std::string, std::string> _mounts,
+                      std::map<std::string, int> _sizes);
+
+    //----------------------------------------------------------------------
+    // Destructor
+    //----------------------------------------------------------------------
+    virtual ~WarmContainerPool();
+
+    //----------------------------------------------------------------------
+    // Method: start
+    //----------------------------------------------------------------------
+    void start();
+
+    //----------------------------------------------------------------------
+    // Method: stop
+    // Stops the filler thread, and removes the idle containers
+    //----------------------------------------------------------------------
+    void stop();
+
+    //----------------------------------------------------------------------
+    // Method: acquire
+    // Takes an idle container for the image, if there is one
+    //----------------------------------------------------------------------
+    bool acquire(const std::string & image, std::string & contId);
+
+    //----------------------------------------------------------------------
+    // Method: bindCommand
+    // Wraps the task command so that its exit code is passed to the
+    // main process of the warm container
+    //----------------------------------------------------------------------
+    static void bindCommand(std::string & exe, std::vector<std::string> & args);
+
+private:
+    //----------------------------------------------------------------------
+    // Method: run
+    //----------------------------------------------------------------------
+    void run();
+
+    //----------------------------------------------------------------------
+    // Method: createWarm
+    //----------------------------------------------------------------------
+    bool createWarm(const std::string & image, std::string & contId);
+
+private:
+    std::shared_ptr<DockerMng> dckMng;
+    std::vector<std::string> labels;
+    std::map<std::string, std::string> mounts;
+    std::map<std::string, int> sizes;
+
+    std::map<std::string, std::deque<std::string>> idle;
+
+    std::atomic<bool> quit;
+    std::mutex mtx;
+    std::condition_variable fillCv;
+    std::thread filler;
+
+    Logger logger;
+
+    static const std::string WarmEntryScript;
+    static const std::string BindScript;
+    static const int RefillPeriod;
+};
+
+#endif // WARMCONTAINERPOOL_H